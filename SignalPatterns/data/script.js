@@ -320,6 +320,12 @@ function renderSpeakerTracks() {
             segDiv.style.width = newWidth + "px";
           }
         }
+
+        // Beim Ziehen live hörbar: Dauer als Patch, höchstens alle PATCH_THROTTLE_MS
+        if (action !== "move") {
+          seg.duration = Math.round(parseInt(segDiv.style.width, 10) * 5);
+          throttleSegmentPatch(i, segIndex, PATCH_DURATION);
+        }
       }
 
       function onUp(e) {
@@ -345,7 +351,11 @@ function renderSpeakerTracks() {
         }
 
         renderSpeakerTracks();
-        debounceSaveSpeakerData();
+        if (action !== "move" && mouseMoved) {
+          sendSegmentPatch(i, segIndex, PATCH_DURATION);
+        } else {
+          debounceSaveSpeakerData();
+        }
         // Modal öffnen, wenn Maus sich nicht bewegt hat (echter Klick)
         if (!mouseMoved) {
           openEditModal(i, segIndex);
@@ -516,22 +526,88 @@ function stopSpeakerLoop() {
 }
 
 // ---- Autosave Debounce ----
-let saveSpeakerTimeout;
+let saveSpeakerTimeout = null;
+let speakerTracksSynced = false;   // Gerät hat denselben Stand wie der Editor (letzter Upload ok)
+let speakerSavesInFlight = 0;
 function debounceSaveSpeakerData() {
+  speakerTracksSynced = false;
   clearTimeout(saveSpeakerTimeout);
   saveSpeakerTimeout = setTimeout(saveSpeakerData, 500);
 }
 
 function saveSpeakerData() {
-  try {
-    fetch("/saveSpeakerData", {
-      method: "POST",
-      headers: { "Content-Type": "application/json" },
-      body: JSON.stringify({ tracks: speakerTracks })
-    });
-  } catch (err) {
+  saveSpeakerTimeout = null;
+  speakerSavesInFlight++;
+  fetch("/saveSpeakerData", {
+    method: "POST",
+    headers: { "Content-Type": "application/json" },
+    body: JSON.stringify({ tracks: speakerTracks })
+  }).then(res => {
+    // Erst nach dem letzten Upload dürfen Patches folgen, sonst überholen sie ihn
+    speakerSavesInFlight--;
+    if (res.ok && speakerSavesInFlight === 0 && saveSpeakerTimeout === null) speakerTracksSynced = true;
+  }).catch(err => {
+    speakerSavesInFlight--;
     console.warn("Save failed:", err);
+  });
+}
+
+// ---- Live-Patches (WebSocket /ws, Format siehe src/track_format.h) ----
+// Einzelne Feldänderungen eines Segments gehen als Binär-Patch (9–17 Bytes) ans Gerät und sind
+// ab der nächsten Segmentgrenze hörbar. Hinzufügen, Löschen, Verschieben und alles, solange das
+// Gerät nicht denselben Stand hat, laufen weiter über den vollständigen Upload.
+const PATCH_FREQ = 1, PATCH_DURATION = 2, PATCH_WAVEFORM = 4, PATCH_TRANSITION = 8;
+const PATCH_MESSAGE_SEGMENT = 1, PATCH_MESSAGE_ACK = 2;
+const PATCH_THROTTLE_MS = 30;
+const WAVEFORM_CODES = { sine: 0, square: 1, sawtooth: 2, triangle: 3 };
+const TRANSITION_CODES = { linear: 0, exp: 1, none: 2 };
+
+let patchSocket = null;
+let patchVersion = 0;
+let patchThrottleTimeout = null;
+
+function connectPatchSocket() {
+  patchSocket = new WebSocket(`ws://${location.host}/ws`);
+  patchSocket.binaryType = "arraybuffer";
+  patchSocket.onmessage = e => {
+    if (!(e.data instanceof ArrayBuffer) || e.data.byteLength < 8) return;
+    const view = new DataView(e.data);
+    if (view.getUint8(0) !== PATCH_MESSAGE_ACK || view.getUint8(1) === 0) return;
+    // Abgelehnt (ungültig, Segment fehlt, Gerät ausgelastet): ganzen Satz hochladen
+    console.warn("Patch", view.getUint32(4, true), "abgelehnt, Status", view.getUint8(1));
+    debounceSaveSpeakerData();
+  };
+  patchSocket.onclose = () => setTimeout(connectPatchSocket, 2000);
+}
+
+function sendSegmentPatch(trackIndex, segIndex, fields) {
+  clearTimeout(patchThrottleTimeout);
+  patchThrottleTimeout = null;
+  if (!speakerTracksSynced || !patchSocket || patchSocket.readyState !== WebSocket.OPEN) {
+    debounceSaveSpeakerData();
+    return;
   }
+
+  const seg = speakerTracks[trackIndex][segIndex];
+  const view = new DataView(new ArrayBuffer(17));
+  view.setUint8(0, PATCH_MESSAGE_SEGMENT);
+  view.setUint8(1, trackIndex);
+  view.setUint16(2, segIndex, true);
+  view.setUint32(4, ++patchVersion, true);
+  view.setUint8(8, fields);
+  let p = 9;
+  if (fields & PATCH_FREQ) { view.setFloat32(p, seg.freq, true); p += 4; }
+  if (fields & PATCH_DURATION) { view.setUint16(p, Math.max(0, Math.min(seg.duration, 65535)), true); p += 2; }
+  if (fields & PATCH_WAVEFORM) view.setUint8(p++, WAVEFORM_CODES[seg.waveform] ?? 0);
+  if (fields & PATCH_TRANSITION) view.setUint8(p++, TRANSITION_CODES[seg.transition] ?? 2);
+  patchSocket.send(view.buffer.slice(0, p));
+}
+
+// Beim Ziehen: erster Patch sofort, danach höchstens einer je PATCH_THROTTLE_MS
+function throttleSegmentPatch(trackIndex, segIndex, fields) {
+  if (patchThrottleTimeout !== null) return;
+  sendSegmentPatch(trackIndex, segIndex, fields);
+  patchThrottleTimeout = setTimeout(() => { patchThrottleTimeout = null; }, PATCH_THROTTLE_MS);
 }
 
 // ---- Beispiel Buttons für Play/Stop ----
@@ -604,13 +680,21 @@ function openEditModal(trackIndex, segIndex) {
 
   // Event-Handler setzen
   document.getElementById("saveSegmentBtn").onclick = () => {
+    const before = { ...seg };
     seg.freq = parseFloat(document.getElementById("editFreq").value);
     seg.waveform = document.getElementById("editWaveform").value;
     seg.duration = parseInt(document.getElementById("editDuration").value, 10);
     seg.transition = document.getElementById("editTransition").value;
 
+    // Nur geänderte Felder schicken
+    let fields = 0;
+    if (seg.freq !== before.freq) fields |= PATCH_FREQ;
+    if (seg.duration !== before.duration) fields |= PATCH_DURATION;
+    if (seg.waveform !== before.waveform) fields |= PATCH_WAVEFORM;
+    if (seg.transition !== before.transition) fields |= PATCH_TRANSITION;
+
     renderSpeakerTracks();
-    debounceSaveSpeakerData();
+    if (fields !== 0) sendSegmentPatch(trackIndex, segIndex, fields);
     closeEditModal();
   };
 
@@ -1270,4 +1354,5 @@ async function sendPatternData(segments) {
 document.addEventListener('templateReady', function() {
   console.log('Template engine ready, starting app initialization');
   init();
+  connectPatchSocket();
 });
@@ -0,0 +1,86 @@
+# Komprimiert die Web-Assets aus data/ mit gzip und bettet sie als Byte-Arrays in die Firmware ein.
+#
+# Läuft als PlatformIO-Pre-Script (extra_scripts = pre:scripts/embed_web_assets.py) vor jedem Build,
+# lässt sich aber auch direkt aufrufen: python scripts/embed_web_assets.py
+#
+# Ergebnis: src/generated/web_assets.h mit Inhalt, Länge, Content-Type und starkem ETag (Hash der
+# komprimierten Bytes) pro Datei. Die Datei wird nur neu geschrieben, wenn sich etwas geändert hat.
+
+import gzip
+import hashlib
+import os
+
+ASSETS = [
+    # (Datei in data/, URL, Content-Type)
+    ("index.html", "/index.html", "text/html"),
+    ("script.js",  "/script.js",  "application/javascript"),
+    ("style.css",  "/style.css",  "text/css"),
+]
+
+try:
+    Import("env")  # noqa: F821 (von PlatformIO bereitgestellt)
+    PROJECT_DIR = env.subst("$PROJECT_DIR")  # noqa: F821
+except NameError:
+    PROJECT_DIR = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+DATA_DIR = os.path.join(PROJECT_DIR, "data")
+OUT_FILE = os.path.join(PROJECT_DIR, "src", "generated", "web_assets.h")
+
+
+def c_array(data):
+    lines = []
+    for i in range(0, len(data), 16):
+        lines.append("  " + ", ".join("0x%02x" % b for b in data[i:i + 16]) + ",")
+    return "\n".join(lines)
+
+
+def generate():
+    parts = [
+        "// Automatisch erzeugt von scripts/embed_web_assets.py – nicht bearbeiten",
+        "#pragma once",
+        "",
+        "#include <stddef.h>",
+        "#include <stdint.h>",
+        "",
+        "struct WebAsset {",
+        "  const char*    path;",
+        "  const char*    contentType;",
+        "  const char*    etag;         // inkl. Anführungszeichen, wie im Header",
+        "  const uint8_t* data;         // gzip",
+        "  size_t         length;",
+        "  size_t         rawLength;",
+        "};",
+        "",
+    ]
+    table = []
+    for idx, (name, url, content_type) in enumerate(ASSETS):
+        with open(os.path.join(DATA_DIR, name), "rb") as f:
+            raw = f.read()
+        packed = gzip.compress(raw, compresslevel=9, mtime=0)
+        etag = hashlib.sha256(packed).hexdigest()[:16]
+        parts.append("// %s: %d -> %d Bytes" % (name, len(raw), len(packed)))
+        parts.append("static const uint8_t WEB_ASSET_%d[] = {" % idx)
+        parts.append(c_array(packed))
+        parts.append("};")
+        parts.append("")
+        table.append('  { "%s", "%s", "\\"%s\\"", WEB_ASSET_%d, %d, %d },'
+                     % (url, content_type, etag, idx, len(packed), len(raw)))
+
+    parts.append("static const WebAsset WEB_ASSETS[] = {")
+    parts.extend(table)
+    parts.append("};")
+    parts.append("constexpr size_t WEB_ASSET_COUNT = %d;" % len(ASSETS))
+    parts.append("")
+    content = "\n".join(parts)
+
+    if os.path.exists(OUT_FILE):
+        with open(OUT_FILE, "r") as f:
+            if f.read() == content:
+                return
+    os.makedirs(os.path.dirname(OUT_FILE), exist_ok=True)
+    with open(OUT_FILE, "w") as f:
+        f.write(content)
+    print("web_assets.h neu erzeugt")
+
+
+generate()
@@ -0,0 +1,76 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "audio_metrics.h"
+
+volatile AudioMetrics audioMetrics = {};
+
+void resetAudioMetrics() {
+  uint32_t rate       = audioMetrics.sampleRateHz;   // Zustand, kein Zähler
+  uint32_t firstSound = audioMetrics.firstSoundUs;
+  memset((void*)&audioMetrics, 0, sizeof(audioMetrics));
+  audioMetrics.sampleRateHz = rate;
+  audioMetrics.firstSoundUs = firstSound;
+}
+
+// snprintf-Kette mit Überlaufprüfung
+struct MetricsWriter {
+  char*  out;
+  size_t capacity;
+  size_t len;
+  bool   ok;
+
+  void append(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+    if (!ok) return;
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(out + len, capacity - len, format, args);
+    va_end(args);
+    if (n < 0 || (size_t)n >= capacity - len) { ok = false; return; }
+    len += (size_t)n;
+  }
+
+  void metric(const char* type, const char* name, const char* help, unsigned long value) {
+    append("# HELP signalpatterns_%s %s\n# TYPE signalpatterns_%s %s\nsignalpatterns_%s %lu\n",
+           name, help, name, type, name, value);
+  }
+};
+
+size_t formatAudioMetrics(char* out, size_t capacity) {
+  MetricsWriter w = { out, capacity, 0, capacity > 0 };
+
+  // Einmal kopieren, damit Histogramm und Summen zueinander passen (soweit ohne Lock möglich)
+  AudioMetrics m;
+  memcpy(&m, (const void*)&audioMetrics, sizeof(m));
+
+  w.metric("counter", "audio_samples_total",          "Ausgegebene Samples", m.samples);
+  w.metric("counter", "audio_silent_samples_total",   "Davon Stille ohne Rendern", m.silentSamples);
+  w.metric("counter", "audio_blocks_total",           "Gerenderte Blöcke", m.blocks);
+  w.metric("counter", "audio_missed_deadlines_total", "Samples/Blöcke nach ihrer Deadline", m.missedDeadlines);
+  w.metric("counter", "audio_underruns_total",        "Ausgabe ohne neues Sample (Ring/DMA leer)", m.underruns);
+  w.metric("gauge",   "audio_lateness_max_us",        "Größte gemessene Verspätung", m.latenessMaxUs);
+  w.metric("gauge",   "audio_render_last_us",         "Renderzeit des letzten Blocks", m.renderLastUs);
+  w.metric("gauge",   "audio_render_max_us",          "Größte Renderzeit eines Blocks", m.renderMaxUs);
+  w.metric("counter", "audio_render_us_total",        "Summe der Renderzeiten", m.renderTotalUs);
+  w.metric("gauge",   "audio_sample_rate_hz",         "Aktuelle Ausgaberate", m.sampleRateHz);
+  w.metric("counter", "switch_events_total",          "Entprellte Schalterwechsel", m.switchCount);
+  w.metric("gauge",   "switch_latency_last_us",       "Erste Flanke bis Reaktion, letzter Wechsel", m.switchLatencyLastUs);
+  w.metric("gauge",   "switch_latency_max_us",        "Erste Flanke bis Reaktion, Maximum", m.switchLatencyMaxUs);
+  w.metric("gauge",   "boot_first_sound_us",          "Start bis zum ersten hörbaren Sample (0 = noch keins)", m.firstSoundUs);
+
+  w.append("# HELP signalpatterns_audio_lateness_us Verspätung je Ausgabe-Ereignis\n"
+           "# TYPE signalpatterns_audio_lateness_us histogram\n");
+  unsigned long cumulative = 0;
+  for (uint8_t i = 0; i + 1 < AUDIO_LATENESS_BUCKETS; ++i) {
+    cumulative += m.lateness[i];
+    // Bucket i enthält Werte < 2^i µs
+    w.append("signalpatterns_audio_lateness_us_bucket{le=\"%lu\"} %lu\n", (1ul << i) - 1, cumulative);
+  }
+  cumulative += m.lateness[AUDIO_LATENESS_BUCKETS - 1];
+  w.append("signalpatterns_audio_lateness_us_bucket{le=\"+Inf\"} %lu\n", cumulative);
+  w.append("signalpatterns_audio_lateness_us_sum %lu\n", (unsigned long)m.latenessTotalUs);
+  w.append("signalpatterns_audio_lateness_us_count %lu\n", cumulative);
+
+  return w.ok ? w.len : 0;
+}
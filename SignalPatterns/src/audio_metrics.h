@@ -0,0 +1,103 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// --------------------------------------
+// Audio-Telemetrie
+// --------------------------------------
+// Genau ein Schreiber (der aktive Audio-Pfad: dacTask bzw. Timer-ISR), Leser sind /metrics und der
+// Serial-Dump. Alle Felder sind 32 Bit breit und werden ohne Lock gelesen; ein Dump kann daher
+// Zähler aus zwei benachbarten Samples mischen, das ist für Telemetrie egal.
+//
+// Verspätung (lateness) je Ausgabe-Ereignis:
+//   DAC_DIRECT  pro Sample: wie weit nach nextTick das Sample geschrieben wurde
+//   TIMER_ISR   pro Sample: wie weit der Interrupt nach dem nominalen Abstand kam
+//   I2S_DMA     pro Block:  wie weit nach dem geschätzten Zeitpunkt, an dem der DMA-Puffer leer läuft
+// Histogramm: Bucket 0 = pünktlich, Bucket i = [2^(i-1), 2^i) µs, der letzte sammelt den Rest.
+
+#define AUDIO_METRICS_INLINE inline __attribute__((always_inline))
+
+constexpr uint8_t AUDIO_LATENESS_BUCKETS = 16;
+
+struct AudioMetrics {
+  uint32_t samples;
+  uint32_t silentSamples;   // davon als Stille ausgegeben, ohne zu rendern
+  uint32_t blocks;
+  uint32_t missedDeadlines;
+  uint32_t underruns;
+  uint32_t lateness[AUDIO_LATENESS_BUCKETS];
+  uint32_t latenessMaxUs;
+  uint32_t latenessTotalUs;
+
+  uint32_t renderLastUs;    // Renderzeit des letzten Blocks
+  uint32_t renderMaxUs;
+  uint32_t renderTotalUs;   // läuft nach ~71 min Rechenzeit über; Prometheus rate() verkraftet das
+
+  uint32_t sampleRateHz;    // aktuelle Ausgaberate (folgt dem gespielten Satz)
+
+  // Schalter → Reaktion: erste Flanke bis controlAudioOutput() fertig (ohne Audio-Puffer)
+  uint32_t switchCount;
+  uint32_t switchLatencyLastUs;
+  uint32_t switchLatencyMaxUs;
+
+  // Boot: esp_timer-Zeit, zu der das erste hörbare Sample (bzw. das echte Horn) ausgegeben wurde,
+  // 0 = noch keins. Wird von resetAudioMetrics() nicht gelöscht.
+  uint32_t firstSoundUs;
+};
+
+extern volatile AudioMetrics audioMetrics;
+
+AUDIO_METRICS_INLINE uint8_t latenessBucket(uint32_t lateUs) {
+  if (lateUs == 0) return 0;
+  uint8_t bucket = (uint8_t)(32 - __builtin_clz(lateUs));
+  return bucket < AUDIO_LATENESS_BUCKETS ? bucket : AUDIO_LATENESS_BUCKETS - 1;
+}
+
+// Ein Ausgabe-Ereignis (Sample oder Block) mit seiner Verspätung; > 0 zählt als verpasste Deadline
+AUDIO_METRICS_INLINE void metricsRecordOutput(uint32_t lateUs) {
+  audioMetrics.lateness[latenessBucket(lateUs)]++;
+  if (lateUs > 0) {
+    audioMetrics.missedDeadlines++;
+    audioMetrics.latenessTotalUs += lateUs;
+    if (lateUs > audioMetrics.latenessMaxUs) audioMetrics.latenessMaxUs = lateUs;
+  }
+}
+
+AUDIO_METRICS_INLINE void metricsRecordUnderrun() {
+  audioMetrics.underruns++;
+}
+
+AUDIO_METRICS_INLINE void metricsRecordSamples(uint32_t count) {
+  audioMetrics.samples += count;
+}
+
+AUDIO_METRICS_INLINE void metricsRecordSilence(uint32_t count) {
+  audioMetrics.silentSamples += count;
+}
+
+AUDIO_METRICS_INLINE void metricsRecordBlock(uint32_t renderUs) {
+  audioMetrics.blocks++;
+  audioMetrics.renderLastUs   = renderUs;
+  audioMetrics.renderTotalUs += renderUs;
+  if (renderUs > audioMetrics.renderMaxUs) audioMetrics.renderMaxUs = renderUs;
+}
+
+AUDIO_METRICS_INLINE void metricsRecordSampleRate(uint32_t rate) {
+  audioMetrics.sampleRateHz = rate;
+}
+
+AUDIO_METRICS_INLINE void metricsRecordSwitch(uint32_t latencyUs) {
+  audioMetrics.switchCount++;
+  audioMetrics.switchLatencyLastUs = latencyUs;
+  if (latencyUs > audioMetrics.switchLatencyMaxUs) audioMetrics.switchLatencyMaxUs = latencyUs;
+}
+
+AUDIO_METRICS_INLINE void metricsRecordFirstSound(uint32_t timeUs) {
+  if (audioMetrics.firstSoundUs == 0) audioMetrics.firstSoundUs = timeUs > 0 ? timeUs : 1;
+}
+
+void resetAudioMetrics();
+
+// Prometheus-Textformat (0.0.4); liefert die Länge ohne Nullterminator, 0 bei zu kleinem Puffer
+size_t formatAudioMetrics(char* out, size_t capacity);
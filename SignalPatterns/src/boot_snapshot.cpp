@@ -0,0 +1,175 @@
+#include <string.h>
+
+#include "boot_snapshot.h"
+
+static inline uint16_t getU16(const uint8_t* p) { uint16_t v; memcpy(&v, p, 2); return v; }
+static inline uint32_t getU32(const uint8_t* p) { uint32_t v; memcpy(&v, p, 4); return v; }
+static inline void     putU16(uint8_t* p, uint16_t v) { memcpy(p, &v, 2); }
+static inline void     putU32(uint8_t* p, uint32_t v) { memcpy(p, &v, 4); }
+
+// --------------------
+// Schreiben
+// --------------------
+struct SnapshotWriter {
+  uint8_t* out;
+  size_t   capacity;
+  size_t   len;
+  uint16_t sections;
+  bool     ok;
+
+  // Reserviert einen Abschnitt; nullptr, wenn er nicht passt
+  uint8_t* section(BootSection id, size_t size) {
+    if (!ok || size > UINT16_MAX || BOOT_SECTION_HEADER + size > capacity - len) {
+      ok = false;
+      return nullptr;
+    }
+    uint8_t* p = out + len;
+    p[0] = (uint8_t)id;
+    p[1] = 0;
+    putU16(p + 2, (uint16_t)size);
+    len += BOOT_SECTION_HEADER + size;
+    sections++;
+    return p + BOOT_SECTION_HEADER;
+  }
+};
+
+// Kopiert s samt Terminator; false, wenn es (mit Terminator) länger als max ist
+static bool putString(uint8_t*& p, const char* s, size_t max) {
+  size_t len = strnlen(s, max);
+  if (len == max) return false;
+  memcpy(p, s, len + 1);
+  p += len + 1;
+  return true;
+}
+
+size_t encodeBootSnapshot(const BootSnapshot& snapshot, uint8_t* out, size_t capacity) {
+  if (capacity < BOOT_SNAPSHOT_HEADER) return 0;
+  SnapshotWriter w = { out, capacity, BOOT_SNAPSHOT_HEADER, 0, true };
+
+  if (snapshot.hasConfig) {
+    const BootConfig& c = snapshot.config;
+    size_t size = strnlen(c.ssid, sizeof(c.ssid)) + strnlen(c.password, sizeof(c.password))
+                + strnlen(c.domain, sizeof(c.domain)) + 3;
+    uint8_t* p = w.section(BootSection::CONFIG, size);
+    if (p != nullptr && !(putString(p, c.ssid, sizeof(c.ssid)) && putString(p, c.password, sizeof(c.password))
+                          && putString(p, c.domain, sizeof(c.domain)))) {
+      return 0;
+    }
+  }
+
+  if (snapshot.hasHonkPattern) {
+    const HonkPattern& pattern = snapshot.honkPattern;
+    uint8_t* p = w.section(BootSection::HONK_PATTERN, 4 + 4 * pattern.patternChanges.size());
+    if (p != nullptr) {
+      p[0] = (uint8_t)pattern.first;
+      p[1] = 0;
+      putU16(p + 2, (uint16_t)pattern.patternChanges.size());
+      p += 4;
+      for (uint32_t ms : pattern.patternChanges) {
+        putU32(p, ms);
+        p += 4;
+      }
+    }
+  }
+
+  if (snapshot.morse != nullptr) {
+    if (snapshot.morseLen > BOOT_SNAPSHOT_MORSE_MAX) return 0;
+    uint8_t* p = w.section(BootSection::MORSE, snapshot.morseLen);
+    if (p != nullptr) memcpy(p, snapshot.morse, snapshot.morseLen);
+  }
+
+  if (snapshot.tracks != nullptr) {
+    uint8_t* p = w.section(BootSection::TRACKS, snapshot.tracksLen);
+    if (p != nullptr) memcpy(p, snapshot.tracks, snapshot.tracksLen);
+  }
+
+  if (!w.ok) return 0;
+
+  memcpy(out, BOOT_SNAPSHOT_MAGIC, 4);
+  out[4] = BOOT_SNAPSHOT_VERSION;
+  out[5] = 0;
+  putU16(out + 6, w.sections);
+  putU32(out + 8, (uint32_t)(w.len - BOOT_SNAPSHOT_HEADER));
+  putU32(out + 12, crc32(out + BOOT_SNAPSHOT_HEADER, w.len - BOOT_SNAPSHOT_HEADER));
+  return w.len;
+}
+
+// --------------------
+// Lesen
+// --------------------
+// Liest einen nullterminierten Wert aus [p, end) nach dst (Kapazität max)
+static bool getString(const uint8_t*& p, const uint8_t* end, char* dst, size_t max) {
+  const uint8_t* nul = (const uint8_t*)memchr(p, '\0', end - p);
+  if (nul == nullptr || (size_t)(nul - p) >= max) return false;
+  memcpy(dst, p, nul - p + 1);
+  p = nul + 1;
+  return true;
+}
+
+static bool decodeConfig(const uint8_t* p, size_t len, BootConfig& out) {
+  const uint8_t* end = p + len;
+  return getString(p, end, out.ssid, sizeof(out.ssid)) && getString(p, end, out.password, sizeof(out.password))
+         && getString(p, end, out.domain, sizeof(out.domain)) && p == end;
+}
+
+static bool decodeHonkPattern(const uint8_t* p, size_t len, HonkPattern& out) {
+  if (len < 4 || p[0] > (uint8_t)FirstSegment::FIRST_LOW) return false;
+  size_t count = getU16(p + 2);
+  if (count > MAX_HONK_PATTERN_CHANGES || len != 4 + 4 * count) return false;
+
+  out.first = (FirstSegment)p[0];
+  out.patternChanges.clear();
+  for (size_t i = 0; i < count; ++i) {
+    uint32_t ms = getU32(p + 4 + 4 * i);
+    out.patternChanges.push_back(ms > 0 ? ms : 1);   // wie beim JSON-Import
+  }
+  return true;
+}
+
+bool decodeBootSnapshot(const uint8_t* data, size_t len, BootSnapshot& out) {
+  out.hasConfig      = false;
+  out.hasHonkPattern = false;
+  out.morse          = nullptr;
+  out.morseLen       = 0;
+  out.tracks         = nullptr;
+  out.tracksLen      = 0;
+
+  if (len < BOOT_SNAPSHOT_HEADER) return false;
+  if (memcmp(data, BOOT_SNAPSHOT_MAGIC, 4) != 0 || data[4] != BOOT_SNAPSHOT_VERSION || data[5] != 0) return false;
+  const size_t body = getU32(data + 8);
+  if (body != len - BOOT_SNAPSHOT_HEADER) return false;
+  if (getU32(data + 12) != crc32(data + BOOT_SNAPSHOT_HEADER, body)) return false;
+
+  const uint8_t* p   = data + BOOT_SNAPSHOT_HEADER;
+  const uint8_t* end = data + len;
+  for (uint16_t i = getU16(data + 6); i > 0; --i) {
+    if ((size_t)(end - p) < BOOT_SECTION_HEADER) return false;
+    const BootSection id   = (BootSection)p[0];
+    const size_t      size = getU16(p + 2);
+    p += BOOT_SECTION_HEADER;
+    if ((size_t)(end - p) < size) return false;
+
+    switch (id) {
+      case BootSection::CONFIG:
+        if (!decodeConfig(p, size, out.config)) return false;
+        out.hasConfig = true;
+        break;
+      case BootSection::HONK_PATTERN:
+        if (!decodeHonkPattern(p, size, out.honkPattern)) return false;
+        out.hasHonkPattern = true;
+        break;
+      case BootSection::MORSE:
+        out.morse    = (const char*)p;
+        out.morseLen = size;
+        break;
+      case BootSection::TRACKS:
+        out.tracks    = p;
+        out.tracksLen = size;
+        break;
+      default:
+        break;   // neuerer Schreiber, gleiche Version: überspringen
+    }
+    p += size;
+  }
+  return p == end;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "honk_pattern.h"
+#include "track_format.h"
+
+// --------------------------------------
+// Boot-Snapshot (/boot.bin)
+// --------------------------------------
+// Alles, was der Boot braucht, in einer Datei: WLAN-Konfiguration, Hupen-Pattern, Morse-Text und
+// Nutzer-Tracks. Ein open/read, ein CRC-Check, kein JSON – die Einzeldateien (config.json,
+// pattern.json, morseMessage.txt, tracks.bin) liest der Boot nur noch, wenn der Snapshot fehlt
+// oder ungültig ist, und schreibt danach einen neuen.
+//
+// Little Endian:
+//    0  char[4]   "SPBS"
+//    4  uint8     Version (BOOT_SNAPSHOT_VERSION)
+//    5  uint8     reserviert (0)
+//    6  uint16    Anzahl Abschnitte
+//    8  uint32    Länge aller Abschnitte (Bytes ab Offset 16)
+//   12  uint32    CRC32 über diese Bytes
+//   16  Abschnitte: uint8 Kennung (BootSection), uint8 reserviert, uint16 Länge, Nutzdaten
+//
+//   CONFIG        ssid, pw, domain, je nullterminiert
+//   HONK_PATTERN  uint8 first, uint8 reserviert, uint16 n, n × uint32 Laufzeit (ms)
+//   MORSE         Text ohne Terminator
+//   TRACKS        tracks.bin unverändert (track_format.h, mit eigener CRC)
+//
+// Fehlt ein Abschnitt, gilt der eingebaute Vorgabewert. Unbekannte Kennungen werden übersprungen;
+// ein inkompatibles Layout bekommt eine neue Version und fällt damit auf JSON zurück.
+
+constexpr uint8_t BOOT_SNAPSHOT_MAGIC[4] = { 'S', 'P', 'B', 'S' };
+constexpr uint8_t BOOT_SNAPSHOT_VERSION  = 1;
+constexpr size_t  BOOT_SNAPSHOT_HEADER   = 16;
+constexpr size_t  BOOT_SECTION_HEADER    = 4;
+
+enum class BootSection : uint8_t { CONFIG = 1, HONK_PATTERN = 2, MORSE = 3, TRACKS = 4 };
+
+// Grenzen wie beim ESP32-SoftAP (SSID 32, Passwort 64 Zeichen)
+struct BootConfig {
+  char ssid[33];
+  char password[65];
+  char domain[64];
+};
+
+constexpr size_t BOOT_SNAPSHOT_MORSE_MAX = 512;   // längere Nachrichten: kein Snapshot, Boot über die Einzeldateien
+constexpr size_t BOOT_SNAPSHOT_MAX_SIZE  = BOOT_SNAPSHOT_HEADER
+                                         + BOOT_SECTION_HEADER + sizeof(BootConfig)
+                                         + BOOT_SECTION_HEADER + 4 + 4 * MAX_HONK_PATTERN_CHANGES
+                                         + BOOT_SECTION_HEADER + BOOT_SNAPSHOT_MORSE_MAX
+                                         + BOOT_SECTION_HEADER + TRACKS_BINARY_MAX_SIZE;
+
+struct BootSnapshot {
+  bool           hasConfig;
+  BootConfig     config;
+  bool           hasHonkPattern;
+  HonkPattern    honkPattern;
+  const char*    morse;       // nicht nullterminiert; nullptr = kein Abschnitt
+  size_t         morseLen;
+  const uint8_t* tracks;      // tracks.bin-Bytes; nullptr = kein Abschnitt
+  size_t         tracksLen;
+};
+
+// 0 bei zu kleinem Puffer oder zu langem Text/Konfigurationswert
+size_t encodeBootSnapshot(const BootSnapshot& snapshot, uint8_t* out, size_t capacity);
+// Prüft Kopf, CRC und Konfiguration/Pattern; morse und tracks zeigen danach in data (die Tracks
+// prüft decodeTracksBinary() beim Übernehmen)
+bool   decodeBootSnapshot(const uint8_t* data, size_t len, BootSnapshot& out);
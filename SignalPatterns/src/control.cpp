@@ -0,0 +1,193 @@
+#include "control.h"
+#include "preset_bank.h"
+#include "synth.h"
+
+DebouncedInput inputs[INPUT_COUNT] = {
+  { GPIO_SIGNAL_ENABLE,  PIN_LOW, PIN_LOW, false, 0, 0 },
+  { GPIO_SIGNAL_SELECT,  PIN_LOW, PIN_LOW, false, 0, 0 },
+  { GPIO_HORN_ENABLE,    PIN_LOW, PIN_LOW, false, 0, 0 },
+  { GPIO_HONK_EMERGENCY, PIN_LOW, PIN_LOW, false, 0, 0 },
+  { GPIO_PRESET_BIT0,    PIN_LOW, PIN_LOW, false, 0, 0 },
+  { GPIO_PRESET_BIT1,    PIN_LOW, PIN_LOW, false, 0, 0 },
+  { GPIO_PRESET_BIT2,    PIN_LOW, PIN_LOW, false, 0, 0 },
+};
+
+volatile bool    honkPatternActive = false;
+std::atomic<int> selectedPreset{-1};
+
+// --------------------
+// Entprellung
+// --------------------
+
+void noteInputEdge(uint8_t input, uint32_t timeUs) {
+  DebouncedInput& in = inputs[input];
+  if (!in.settling) {
+    in.settling    = true;
+    in.firstEdgeUs = timeUs;
+  }
+}
+
+bool settleInputs(uint32_t nowUs, uint32_t& waitUs, uint32_t& firstEdgeUs) {
+  const uint32_t debounceUs = DEBOUNCE_MS * 1000;
+  bool changed = false;
+  waitUs = UINT32_MAX;
+
+  for (DebouncedInput& in : inputs) {
+    if (!in.settling) continue;
+
+    // Die ISR setzt lastEdgeUs auch während dieser Schleife: eine Flanke nach nowUs heißt keine Ruhe
+    int32_t  sinceEdge = (int32_t)(nowUs - in.lastEdgeUs);
+    uint32_t quiet     = sinceEdge > 0 ? (uint32_t)sinceEdge : 0;
+    if (quiet < debounceUs) {
+      if (debounceUs - quiet < waitUs) waitUs = debounceUs - quiet;
+      continue;
+    }
+
+    in.settling = false;
+    uint8_t level = readInputPin(in.pin);
+    if (level == in.state) continue;   // nur geprellt
+
+    in.state = level;
+    if (!changed || (int32_t)(in.firstEdgeUs - firstEdgeUs) < 0) firstEdgeUs = in.firstEdgeUs;
+    changed = true;
+  }
+  return changed;
+}
+
+// Wie früher debouncedInputHasChanged: true genau einmal pro entprelltem Wechsel
+bool inputHasChanged(InputId input) {
+  DebouncedInput& in = inputs[input];
+  if (in.state == in.handledState) return false;
+  in.handledState = in.state;
+  return true;
+}
+
+// Nach dem Einschalten (auch nach einem Brown-out) gelten die Pegel, die schon anliegen: alle
+// Eingänge als geändert auswerten, statt auf die erste Flanke zu warten
+void applyInputsAtBoot() {
+  for (DebouncedInput& in : inputs) in.handledState = in.state == PIN_HIGH ? PIN_LOW : PIN_HIGH;
+  controlAudioOutput();
+}
+
+bool signalIsEnabled() {
+  return inputs[INPUT_SIGNAL_ENABLE].state == PIN_HIGH;
+}
+
+bool emergencyIsSelected() {
+  return inputs[INPUT_SIGNAL_SELECT].state == PIN_LOW;
+}
+
+bool synthesizeHorn() {
+  return inputs[INPUT_HORN_ENABLE].state == PIN_HIGH;
+}
+
+bool useHornForEmergencySignal() {
+  return inputs[INPUT_HONK_EMERGENCY].state == PIN_LOW;
+}
+
+int presetFromInputs() {
+  int code = 0;
+  for (uint8_t bit = 0; bit < 3; ++bit) {
+    if (inputs[INPUT_PRESET_BIT0 + bit].state == PIN_LOW) code |= 1 << bit;
+  }
+  return code - 1;
+}
+
+// Aus Controller-Task (GPIO) und Web-Handler; der letzte Aufruf gilt. Spielt gerade das
+// Notfallsignal aus den Tracks, wechselt es am nächsten Blockanfang.
+void choosePreset(int index) {
+  const TrackSet* preset = index >= 0 ? presetTracks((size_t)index) : nullptr;
+  if (preset == nullptr) index = -1;
+  selectedPreset.store(index);
+  selectPreset(preset);
+
+  TrackSource source = requestedSource.load();
+  if (source != TrackSource::HORN) selectTracks(index >= 0 ? TrackSource::PRESET : TrackSource::USER);
+}
+
+// --------------------
+// Entscheidungen
+// --------------------
+
+// DAC-Ausgabe starten bzw. nach einer Pause fortsetzen
+static void runDacOutput() {
+  if (!dacTaskRunning()) startDacTask();
+  else resumeDacOutput();
+}
+
+void controlAudioOutput() {
+    // Preset-Wahl gilt auch bei abgeschaltetem Signal; alle Bits abfragen, damit keins hängen bleibt
+    bool presetChanged = false;
+    for (uint8_t i = INPUT_PRESET_BIT0; i <= INPUT_PRESET_BIT2; ++i) presetChanged |= inputHasChanged((InputId)i);
+    if (presetChanged) choosePreset(presetFromInputs());
+
+    // Horn-Quelle gewechselt: der Horn-Task schaltet das Relais nur, solange das Horn nicht synthetisiert wird
+    if (inputHasChanged(INPUT_HORN_ENABLE)) notifyHornTask();
+
+    bool signalEnabledChanged = inputHasChanged(INPUT_SIGNAL_ENABLE);
+    bool signalEnabled = signalIsEnabled();
+
+    if (signalEnabledChanged && !signalEnabled) {
+      stopHonkPattern();
+      stopRealHorn();
+      stopDacOutput();
+      return;
+    }
+
+    if (!(signalEnabledChanged || signalEnabled)) {
+      return;
+    }
+
+    updateAcousticSignal();
+
+}
+
+void updateAcousticSignal() {
+  bool selectionHasChanged = inputHasChanged(INPUT_SIGNAL_SELECT);
+  bool emergencySignalSelectionHasChanged = inputHasChanged(INPUT_HONK_EMERGENCY);
+
+  if (selectionHasChanged && !emergencyIsSelected()) {
+    honk();
+  } else if (emergencyIsSelected() && (selectionHasChanged || emergencySignalSelectionHasChanged)) {
+    emergencySignal();
+  }
+}
+
+void honk() {
+  stopHonkPattern();   // Dauerton
+  if (synthesizeHorn()) {
+    selectTracks(TrackSource::HORN);
+    runDacOutput();
+  } else {
+    playRealHorn();
+  }
+}
+
+void emergencySignal() {
+  if (useHornForEmergencySignal()) {
+    startHonkPattern();
+  } else {
+    stopHonkPattern();
+    selectTracks(selectedPreset.load() >= 0 ? TrackSource::PRESET : TrackSource::USER);
+    runDacOutput();
+  }
+}
+
+void startHonkPattern() {
+  honkPatternActive = true;
+  publishHonkPattern();
+
+  if (synthesizeHorn()) {
+    selectTracks(TrackSource::HORN);
+    runDacOutput();
+  } else {
+    pauseDacOutput();   // echtes Horn: der Lautsprecher schweigt
+  }
+}
+
+void stopHonkPattern() {
+  if (!honkPatternActive) return;
+  honkPatternActive = false;
+  publishGate(nullptr);
+  notifyHornTask();
+}
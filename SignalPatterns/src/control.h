@@ -0,0 +1,86 @@
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+
+// --------------------------------------
+// Steuerung: Schalter → Signal (plattformfrei)
+// --------------------------------------
+// Entprellung und die Entscheidung, welche Ausgabe ein Schalterwechsel startet, anhält oder
+// weiterlaufen lässt. Die Ausgänge (DAC-Task, Horn-Relais, Horn-Task) erreicht die Steuerung nur über
+// die Hooks unten: esp32dev main.cpp, native native/replay (GPIO-Traces gegen simulierte Zeit,
+// Pins und Tasks).
+
+// Eingänge (ESP32-GPIO)
+constexpr uint8_t GPIO_SIGNAL_ENABLE  = 34; // HIGH: Enable
+constexpr uint8_t GPIO_SIGNAL_SELECT  = 35; // HIGH: DEFAULT; LOW: EMERGENCY
+
+constexpr uint8_t GPIO_HORN_ENABLE    = 12; // LOW: Enable → echtes Horn
+constexpr uint8_t GPIO_HONK_EMERGENCY = 14; // LOW: Enable → erzwingt Nutzung des Horns
+
+// Preset-Auswahl für das Notfallsignal, binär (LOW = Bit gesetzt, Pull-up): 0 = Nutzersatz,
+// n = Preset n - 1 der Bank (preset_bank.h); unbeschaltet bleibt es beim Nutzersatz
+constexpr uint8_t GPIO_PRESET_BIT0    = 32;
+constexpr uint8_t GPIO_PRESET_BIT1    = 33;
+constexpr uint8_t GPIO_PRESET_BIT2    = 27;
+
+// Pegel wie LOW/HIGH bei Arduino
+constexpr uint8_t PIN_LOW  = 0;
+constexpr uint8_t PIN_HIGH = 1;
+
+// Ein Eingang gilt als stabil, sobald DEBOUNCE_MS lang keine Flanke mehr kam; dann wird der Pin neu
+// gelesen und der Pegel übernommen
+constexpr unsigned long DEBOUNCE_MS = 10L;
+
+enum InputId : uint8_t { INPUT_SIGNAL_ENABLE, INPUT_SIGNAL_SELECT, INPUT_HORN_ENABLE, INPUT_HONK_EMERGENCY,
+                         INPUT_PRESET_BIT0, INPUT_PRESET_BIT1, INPUT_PRESET_BIT2, INPUT_COUNT };
+
+struct DebouncedInput {
+  uint8_t           pin;
+  uint8_t           state;          // entprellter Pegel
+  uint8_t           handledState;   // zuletzt von controlAudioOutput() ausgewerteter Pegel
+  bool              settling;       // Flanken seit der letzten Übernahme
+  uint32_t          firstEdgeUs;    // erste Flanke der laufenden Prell-Serie (für die Latenz)
+  volatile uint32_t lastEdgeUs;     // letzte Flanke, direkt von der ISR gesetzt
+};
+
+extern DebouncedInput    inputs[INPUT_COUNT];
+extern volatile bool     honkPatternActive;
+extern std::atomic<int>  selectedPreset;   // Index in der Preset-Bank, -1 = Nutzersatz
+
+// --- Entprellung (Controller-Task) ---
+// Erste Flanke einer Serie merken; lastEdgeUs setzt die ISR selbst
+void noteInputEdge(uint8_t input, uint32_t timeUs);
+// Übernimmt Eingänge, deren letzte Flanke DEBOUNCE_MS zurückliegt. Liefert true bei einem
+// Pegelwechsel (firstEdgeUs: früheste erste Flanke der übernommenen Serien); waitUs ist danach die
+// Zeit bis zum nächsten fälligen Eingang, UINT32_MAX ohne laufende Serie.
+bool settleInputs(uint32_t nowUs, uint32_t& waitUs, uint32_t& firstEdgeUs);
+bool inputHasChanged(InputId input);   // true genau einmal pro entprelltem Wechsel
+void applyInputsAtBoot();
+
+bool signalIsEnabled();
+bool emergencyIsSelected();
+bool synthesizeHorn();
+bool useHornForEmergencySignal();
+int  presetFromInputs();
+void choosePreset(int index);   // -1: Nutzersatz
+
+// --- Entscheidungen ---
+void controlAudioOutput();
+void updateAcousticSignal();
+void honk();
+void emergencySignal();
+void startHonkPattern();
+void stopHonkPattern();
+
+// --- Hooks (Plattform) ---
+uint8_t readInputPin(uint8_t pin);   // aktueller Pegel, nach der Ruhezeit
+bool    dacTaskRunning();            // DAC-Task existiert (auch angehalten)
+void    startDacTask();
+void    pauseDacOutput();
+void    resumeDacOutput();
+void    stopDacOutput();
+void    playRealHorn();
+void    stopRealHorn();
+void    publishHonkPattern();        // aktuelles Hupen-Pattern an Audio-Pfad und Horn-Task
+void    notifyHornTask();
@@ -0,0 +1,379 @@
+#include <Arduino.h>
+#include <AsyncTCP.h>
+#include <esp_freertos_hooks.h>
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "audio_metrics.h"
+#include "diagnostics.h"
+#include "main.h"
+#include "persistence.h"
+
+#if configUSE_TRACE_FACILITY && configGENERATE_RUN_TIME_STATS
+#define DIAG_CPU_STATS 1
+#else
+#define DIAG_CPU_STATS 0
+#endif
+
+#ifndef CONFIG_ASYNC_TCP_STACK_SIZE
+#define CONFIG_ASYNC_TCP_STACK_SIZE 0   // unbekannt
+#endif
+
+const char* const DIAG_TASK_NAMES[DIAG_TASK_COUNT] = { "dac", "horn", "controller", "persist", "web", "loop" };
+
+// Fremde Tasks (AsyncTCP, Arduino-loop) werden über ihren Namen gefunden
+static const char* const WEB_TASK  = "async_tcp";
+static const char* const LOOP_TASK = "loopTask";
+
+// --------------------
+// Zustand (schreibt nur sampleDiagnostics())
+// --------------------
+static TaskHealth taskHealth[DIAG_TASK_COUNT];
+static bool       stackWarned[DIAG_TASK_COUNT];
+
+static HeapSample heapHistory[DIAG_HEAP_HISTORY];
+static uint8_t    heapHistoryNext  = 0;
+static uint8_t    heapHistoryCount = 0;
+static uint32_t   minLargestBlock  = 0xFFFFFFFF;
+static uint32_t   lastSampleMs     = 0;
+static bool       sampledOnce      = false;
+
+static uint16_t   coreBusy[DIAG_CORE_COUNT];
+static uint32_t   lastCpuUs        = 0;
+static bool       cpuBaseline      = false;   // vorige Messung vorhanden
+
+#if DIAG_CPU_STATS
+constexpr UBaseType_t DIAG_MAX_TASKS = 24;
+static TaskStatus_t taskStatus[DIAG_MAX_TASKS];
+static uint32_t     lastRunTime[DIAG_TASK_COUNT];
+static TaskHandle_t lastRunHandle[DIAG_TASK_COUNT];   // Task, zu dem lastRunTime gehört
+static uint32_t     lastTotalRunTime = 0;
+#endif
+
+// --------------------
+// Core-Auslastung über Idle-Hooks
+// --------------------
+// Der Hook läuft im Idle-Task seines Cores und summiert die Zeit zwischen zwei direkt aufeinander
+// folgenden Aufrufen. Eine längere Lücke als DIAG_IDLE_GAP_US heißt: ein Task hatte den Core.
+// Kürzere Unterbrechungen (ISRs, sehr kurze Task-Läufe) zählen als Leerlauf; die Auslastung ist also
+// eher zu niedrig. Der Hook gibt false zurück, damit der Idle-Task nicht per waiti bis zum nächsten
+// Interrupt schläft – Schlafen wäre sonst nicht von belegter Zeit zu unterscheiden.
+static volatile uint32_t idleUs[portNUM_PROCESSORS];       // schreibt nur der Hook des Cores
+static uint32_t          idleLastUs[portNUM_PROCESSORS];
+static uint32_t          lastIdleUs[portNUM_PROCESSORS];   // Stand der vorigen Messung
+static bool              idleHooked[portNUM_PROCESSORS];
+
+static bool countIdle() {
+  BaseType_t core = xPortGetCoreID();
+  uint32_t   now  = (uint32_t)esp_timer_get_time();
+  uint32_t   gap  = now - idleLastUs[core];
+  if (gap <= DIAG_IDLE_GAP_US) idleUs[core] += gap;
+  idleLastUs[core] = now;
+  return false;
+}
+
+static void startIdleCounters() {
+  for (BaseType_t core = 0; core < portNUM_PROCESSORS; ++core) {
+    idleHooked[core] = esp_register_freertos_idle_hook_for_cpu(countIdle, core) == ESP_OK;
+  }
+}
+
+static TaskHandle_t taskHandle(uint8_t task) {
+  static TaskHandle_t webHandle  = NULL;
+  static TaskHandle_t loopHandle = NULL;
+  switch (task) {
+    case DIAG_TASK_DAC:        return dacTaskHandle;
+    case DIAG_TASK_HORN:       return hornTaskHandle;
+    case DIAG_TASK_CONTROLLER: return controllerTaskHandle;
+    case DIAG_TASK_PERSIST:    return persistTaskHandle;
+    case DIAG_TASK_WEB:
+      if (webHandle == NULL) webHandle = xTaskGetHandle(WEB_TASK);   // entsteht erst mit dem ersten Client
+      return webHandle;
+    case DIAG_TASK_LOOP:
+      if (loopHandle == NULL) loopHandle = xTaskGetHandle(LOOP_TASK);
+      return loopHandle;
+  }
+  return NULL;
+}
+
+static uint32_t taskStackBytes(uint8_t task) {
+  switch (task) {
+    case DIAG_TASK_DAC:        return DAC_TASK_STACK;
+    case DIAG_TASK_HORN:       return HORN_TASK_STACK;
+    case DIAG_TASK_CONTROLLER: return CONTROLLER_TASK_STACK;
+    case DIAG_TASK_PERSIST:    return PERSIST_TASK_STACK;
+    case DIAG_TASK_WEB:        return CONFIG_ASYNC_TCP_STACK_SIZE;
+    case DIAG_TASK_LOOP:       return getArduinoLoopTaskStackSize();
+  }
+  return 0;
+}
+
+// High-Water-Mark in Bytes (ESP-IDF: StackType_t ist uint8_t). Der DAC-Task beendet sich selbst und
+// löscht sein Handle unter dacTaskMux; gelesen und gemessen wird deshalb unter derselben Sperre.
+static uint32_t taskStackFreeMin(uint8_t task) {
+  uint32_t freeMin = DIAG_STACK_UNKNOWN;
+  if (task == DIAG_TASK_DAC) {
+    portENTER_CRITICAL(&dacTaskMux);
+    if (dacTaskHandle != NULL) freeMin = uxTaskGetStackHighWaterMark(dacTaskHandle);
+    portEXIT_CRITICAL(&dacTaskMux);
+    return freeMin;
+  }
+  TaskHandle_t handle = taskHandle(task);
+  return handle != NULL ? uxTaskGetStackHighWaterMark(handle) : freeMin;
+}
+
+static void sampleStacks() {
+  for (uint8_t t = 0; t < DIAG_TASK_COUNT; ++t) {
+    TaskHealth& h = taskHealth[t];
+    h.stackBytes   = taskStackBytes(t);
+    h.stackFreeMin = taskStackFreeMin(t);
+    if (h.stackFreeMin == DIAG_STACK_UNKNOWN) continue;
+    if (h.stackFreeMin < DIAG_STACK_WARN_BYTES && !stackWarned[t]) {
+      stackWarned[t] = true;
+      Serial.printf("Warnung: Stack von %s fast voll (%lu Bytes frei)\n", DIAG_TASK_NAMES[t], (unsigned long)h.stackFreeMin);
+    }
+  }
+}
+
+static void sampleCoreLoad(bool baseline, uint32_t elapsedUs) {
+  for (uint8_t core = 0; core < DIAG_CORE_COUNT; ++core) {
+    coreBusy[core] = DIAG_CPU_UNKNOWN;
+    if (core >= portNUM_PROCESSORS || !idleHooked[core]) continue;
+    uint32_t idle = idleUs[core];
+    if (baseline && elapsedUs > 0) {
+      uint32_t idleDelta = idle - lastIdleUs[core];
+      coreBusy[core] = idleDelta < elapsedUs ? (uint16_t)(1000 - (uint64_t)idleDelta * 1000 / elapsedUs) : 0;
+    }
+    lastIdleUs[core] = idle;
+  }
+}
+
+#if DIAG_CPU_STATS
+static void sampleTaskRunTime() {
+  uint32_t totalRunTime = 0;
+  UBaseType_t count = uxTaskGetSystemState(taskStatus, DIAG_MAX_TASKS, &totalRunTime);
+  uint32_t elapsed = totalRunTime - lastTotalRunTime;
+  bool valid = lastTotalRunTime != 0 && elapsed > 0 && count > 0;   // count 0: mehr Tasks als Platz
+
+  for (uint8_t t = 0; t < DIAG_TASK_COUNT; ++t) {
+    TaskHandle_t handle = taskHandle(t);
+    taskHealth[t].cpuPermille = DIAG_CPU_UNKNOWN;
+    if (handle == NULL) continue;
+    for (UBaseType_t i = 0; i < count; ++i) {
+      if (taskStatus[i].xHandle != handle) continue;
+      uint32_t runTime = taskStatus[i].ulRunTimeCounter;
+      if (valid && lastRunHandle[t] == handle) {   // neu erzeugter Task (DAC): erst eine neue Basis
+        uint64_t permille = (uint64_t)(runTime - lastRunTime[t]) * 1000 / elapsed;
+        taskHealth[t].cpuPermille = (uint16_t)(permille < 1000 ? permille : 1000);
+      }
+      lastRunTime[t]   = runTime;
+      lastRunHandle[t] = handle;
+      break;
+    }
+  }
+  lastTotalRunTime = totalRunTime;
+}
+#else
+// Ohne Run-Time-Stats: nur der DAC-Task, aus seiner Renderzeit. i2s_write und die Ausgabe der Stille
+// fehlen darin; die anderen Modi messen keine Renderzeit.
+static uint32_t lastRenderUs = 0;
+
+static void estimateDacCpu(bool baseline, uint32_t elapsedUs) {
+  uint32_t render = audioMetrics.renderTotalUs;
+  uint32_t delta  = render - lastRenderUs;
+  if (delta > elapsedUs) delta = render;   // resetAudioMetrics() dazwischen
+  lastRenderUs = render;
+  if (!baseline || elapsedUs == 0 || dacTaskHandle == NULL) return;
+  if (AUDIO_OUTPUT_MODE != AudioOutputMode::I2S_DMA) return;
+  uint64_t permille = (uint64_t)delta * 1000 / elapsedUs;
+  taskHealth[DIAG_TASK_DAC].cpuPermille = (uint16_t)(permille < 1000 ? permille : 1000);
+}
+#endif
+
+static void sampleCpu(uint32_t nowUs) {
+  uint32_t elapsedUs = nowUs - lastCpuUs;
+  bool     baseline  = cpuBaseline;
+  lastCpuUs   = nowUs;
+  cpuBaseline = true;
+
+  sampleCoreLoad(baseline, elapsedUs);
+#if DIAG_CPU_STATS
+  sampleTaskRunTime();
+#else
+  for (uint8_t t = 0; t < DIAG_TASK_COUNT; ++t) taskHealth[t].cpuPermille = DIAG_CPU_UNKNOWN;
+  estimateDacCpu(baseline, elapsedUs);
+#endif
+}
+
+static void sampleHeap(uint32_t nowMs) {
+  HeapSample& s = heapHistory[heapHistoryNext];
+  s.uptimeS      = nowMs / 1000;
+  s.freeBytes    = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+  s.largestBlock = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+  if (s.largestBlock < minLargestBlock) minLargestBlock = s.largestBlock;
+
+  heapHistoryNext = (uint8_t)((heapHistoryNext + 1) % DIAG_HEAP_HISTORY);
+  if (heapHistoryCount < DIAG_HEAP_HISTORY) heapHistoryCount++;
+}
+
+void sampleDiagnostics() {
+  uint32_t now = millis();
+  if (sampledOnce && now - lastSampleMs < DIAG_SAMPLE_MS) return;
+  if (!sampledOnce) startIdleCounters();   // erste Messung ist die Basis
+  sampledOnce  = true;
+  lastSampleMs = now;
+
+  sampleStacks();
+  sampleCpu((uint32_t)esp_timer_get_time());
+  sampleHeap(now);
+}
+
+// --------------------
+// Ausgabe
+// --------------------
+// Aktuelle Werte (Heap, Stacks) werden beim Abruf frisch gelesen, CPU-Anteile und Verlauf stammen
+// aus der letzten Messung
+struct DiagnosticsNow {
+  uint32_t   uptimeS;
+  uint32_t   freeBytes;
+  uint32_t   minFreeBytes;
+  uint32_t   largestBlock;
+  uint32_t   minLargestBlock;
+  uint8_t    trackSetsInUse;
+  uint8_t    gatesInUse;
+  uint16_t   coreBusyPermille[DIAG_CORE_COUNT];
+  TaskHealth tasks[DIAG_TASK_COUNT];
+};
+
+static void readDiagnosticsNow(DiagnosticsNow& d) {
+  d.uptimeS         = millis() / 1000;
+  d.freeBytes       = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+  d.minFreeBytes    = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+  d.largestBlock    = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+  d.minLargestBlock = d.largestBlock < minLargestBlock ? d.largestBlock : minLargestBlock;
+  d.trackSetsInUse  = (uint8_t)trackSetsInUse();
+  d.gatesInUse      = (uint8_t)gatesInUse();
+  for (uint8_t core = 0; core < DIAG_CORE_COUNT; ++core) d.coreBusyPermille[core] = coreBusy[core];
+  for (uint8_t t = 0; t < DIAG_TASK_COUNT; ++t) {
+    d.tasks[t].stackBytes   = taskStackBytes(t);
+    d.tasks[t].stackFreeMin = taskStackFreeMin(t);
+    d.tasks[t].cpuPermille  = taskHealth[t].cpuPermille;
+  }
+}
+
+static uint16_t fragmentationPermille(uint32_t freeBytes, uint32_t largestBlock) {
+  if (freeBytes == 0) return 0;
+  return (uint16_t)(1000 - (uint64_t)largestBlock * 1000 / freeBytes);
+}
+
+// snprintf-Kette mit Überlaufprüfung (wie in audio_metrics.cpp)
+struct DiagWriter {
+  char*  out;
+  size_t capacity;
+  size_t len;
+  bool   ok;
+
+  void append(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+    if (!ok) return;
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(out + len, capacity - len, format, args);
+    va_end(args);
+    if (n < 0 || (size_t)n >= capacity - len) { ok = false; return; }
+    len += (size_t)n;
+  }
+};
+
+size_t formatDiagnosticsJson(char* out, size_t capacity) {
+  DiagWriter w = { out, capacity, 0, capacity > 0 };
+  DiagnosticsNow d;
+  readDiagnosticsNow(d);
+
+  w.append("{\"uptimeS\":%lu,\"heap\":{\"free\":%lu,\"minFree\":%lu,\"largestBlock\":%lu,"
+           "\"minLargestBlock\":%lu,\"fragmentationPermille\":%u},"
+           "\"pools\":{\"trackSets\":%u,\"trackSetsCapacity\":%u,\"gates\":%u,\"gatesCapacity\":%u},"
+           "\"taskCpuExact\":%s,\"coreBusyPermille\":[",
+           (unsigned long)d.uptimeS, (unsigned long)d.freeBytes, (unsigned long)d.minFreeBytes,
+           (unsigned long)d.largestBlock, (unsigned long)d.minLargestBlock,
+           (unsigned)fragmentationPermille(d.freeBytes, d.largestBlock),
+           (unsigned)d.trackSetsInUse, (unsigned)TRACK_SET_POOL_SIZE, (unsigned)d.gatesInUse, (unsigned)GATE_POOL_SIZE,
+           DIAG_CPU_STATS ? "true" : "false");
+  for (uint8_t core = 0; core < DIAG_CORE_COUNT; ++core) {
+    if (d.coreBusyPermille[core] == DIAG_CPU_UNKNOWN) w.append("%snull", core > 0 ? "," : "");
+    else w.append("%s%u", core > 0 ? "," : "", (unsigned)d.coreBusyPermille[core]);
+  }
+  w.append("],\"tasks\":{");
+
+  for (uint8_t t = 0; t < DIAG_TASK_COUNT; ++t) {
+    const TaskHealth& h = d.tasks[t];
+    w.append("%s\"%s\":{\"stack\":%lu,", t > 0 ? "," : "", DIAG_TASK_NAMES[t], (unsigned long)h.stackBytes);
+    if (h.stackFreeMin == DIAG_STACK_UNKNOWN) w.append("\"stackFreeMin\":null,");
+    else w.append("\"stackFreeMin\":%lu,", (unsigned long)h.stackFreeMin);
+    if (h.cpuPermille == DIAG_CPU_UNKNOWN) w.append("\"cpuPermille\":null}");
+    else w.append("\"cpuPermille\":%u}", (unsigned)h.cpuPermille);
+  }
+
+  // Verlauf als [uptimeS, free, largestBlock], älteste zuerst
+  w.append("},\"heapHistory\":[");
+  uint8_t count = heapHistoryCount;
+  uint8_t first = (uint8_t)((heapHistoryNext + DIAG_HEAP_HISTORY - count) % DIAG_HEAP_HISTORY);
+  for (uint8_t i = 0; i < count; ++i) {
+    const HeapSample& s = heapHistory[(first + i) % DIAG_HEAP_HISTORY];
+    w.append("%s[%lu,%lu,%lu]", i > 0 ? "," : "",
+             (unsigned long)s.uptimeS, (unsigned long)s.freeBytes, (unsigned long)s.largestBlock);
+  }
+  w.append("]}\n");
+
+  return w.ok ? w.len : 0;
+}
+
+static inline uint8_t* putU16(uint8_t* p, uint16_t v) { memcpy(p, &v, 2); return p + 2; }
+static inline uint8_t* putU32(uint8_t* p, uint32_t v) { memcpy(p, &v, 4); return p + 4; }
+
+constexpr size_t DIAG_BINARY_HEADER = 32 + DIAG_CORE_COUNT * 2;
+
+static_assert(DIAG_BINARY_HEADER + DIAG_TASK_COUNT * 12 + DIAG_HEAP_HISTORY * 12 <= DIAG_BINARY_SIZE, "DIAG_BINARY_SIZE zu klein");
+
+size_t formatDiagnosticsBinary(uint8_t* out, size_t capacity) {
+  uint8_t count = heapHistoryCount;   // Verlauf wächst evtl. parallel in loop()
+  size_t  size  = DIAG_BINARY_HEADER + DIAG_TASK_COUNT * 12 + (size_t)count * 12;
+  if (capacity < size) return 0;
+
+  DiagnosticsNow d;
+  readDiagnosticsNow(d);
+
+  uint8_t* p = out;
+  memcpy(p, "SPDG", 4); p += 4;
+  *p++ = DIAG_BINARY_VERSION;
+  *p++ = DIAG_TASK_COUNT;
+  *p++ = count;
+  *p++ = DIAG_CPU_STATS ? 1 : 2;
+  p = putU32(p, d.uptimeS);
+  p = putU32(p, d.freeBytes);
+  p = putU32(p, d.minFreeBytes);
+  p = putU32(p, d.largestBlock);
+  p = putU32(p, d.minLargestBlock);
+  *p++ = d.trackSetsInUse;
+  *p++ = d.gatesInUse;
+  p = putU16(p, 0);
+  for (uint8_t core = 0; core < DIAG_CORE_COUNT; ++core) p = putU16(p, d.coreBusyPermille[core]);
+
+  for (uint8_t t = 0; t < DIAG_TASK_COUNT; ++t) {
+    p = putU32(p, d.tasks[t].stackBytes);
+    p = putU32(p, d.tasks[t].stackFreeMin);
+    p = putU16(p, d.tasks[t].cpuPermille);
+    p = putU16(p, 0);
+  }
+
+  uint8_t first = (uint8_t)((heapHistoryNext + DIAG_HEAP_HISTORY - count) % DIAG_HEAP_HISTORY);
+  for (uint8_t i = 0; i < count; ++i) {
+    const HeapSample& s = heapHistory[(first + i) % DIAG_HEAP_HISTORY];
+    p = putU32(p, s.uptimeS);
+    p = putU32(p, s.freeBytes);
+    p = putU32(p, s.largestBlock);
+  }
+  return (size_t)(p - out);
+}
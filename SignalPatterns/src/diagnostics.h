@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// --------------------------------------
+// Speicher- und Task-Diagnose
+// --------------------------------------
+// Für das Dimensionieren der Stacks und zum Erkennen von Heap-Fragmentierung im Dauerbetrieb:
+//   - Stack-High-Water-Mark je Task (kleinster freier Stack seit dem Start, Bytes)
+//   - freier Heap, kleinster freier Heap seit dem Start und größter freier Block, mit Verlauf
+//   - Auslastung je Core seit der letzten Messung, geschätzt über Idle-Hooks (auch im fertigen Arduino-Core)
+//   - CPU-Anteil je Task seit der letzten Messung: exakt mit configGENERATE_RUN_TIME_STATS, sonst nur
+//     für den DAC-Task, geschätzt aus der Renderzeit (audioMetrics.renderTotalUs, I2S_DMA)
+// Gemessen wird aus loop() (sampleDiagnostics()); Leser sind /diagnostics, /diagnostics.bin und
+// der Serial-Befehl d. Gelesen wird ohne Lock, wie bei den Audio-Metriken.
+
+constexpr uint32_t DIAG_SAMPLE_MS         = 10000;   // Abstand der Messungen
+constexpr uint8_t  DIAG_HEAP_HISTORY      = 60;      // Verlaufseinträge → 10 min
+constexpr uint32_t DIAG_STACK_WARN_BYTES  = 512;     // darunter einmalige Warnung auf Serial
+constexpr size_t   DIAG_TEXT_SIZE         = 2560;    // JSON (/diagnostics und Serial-Dump)
+constexpr size_t   DIAG_BINARY_SIZE       = 1024;    // /diagnostics.bin
+
+constexpr uint32_t DIAG_IDLE_GAP_US       = 20;      // längere Lücke zwischen zwei Idle-Hook-Aufrufen = Core belegt
+constexpr uint8_t  DIAG_CORE_COUNT        = 2;       // Plätze im Format; fehlende Cores bleiben unbekannt
+
+constexpr uint16_t DIAG_CPU_UNKNOWN       = 0xFFFF;  // nicht messbar bzw. vor der zweiten Messung
+constexpr uint32_t DIAG_STACK_UNKNOWN     = 0xFFFFFFFF;   // Task läuft nicht
+
+enum DiagTask : uint8_t { DIAG_TASK_DAC, DIAG_TASK_HORN, DIAG_TASK_CONTROLLER, DIAG_TASK_PERSIST, DIAG_TASK_WEB, DIAG_TASK_LOOP, DIAG_TASK_COUNT };
+
+struct TaskHealth {
+  uint32_t stackBytes;     // angelegte Stackgröße, 0 = unbekannt
+  uint32_t stackFreeMin;   // High-Water-Mark in Bytes, DIAG_STACK_UNKNOWN wenn der Task nicht läuft
+  uint16_t cpuPermille;    // Anteil an einem Core seit der vorigen Messung, DIAG_CPU_UNKNOWN
+};
+
+struct HeapSample {
+  uint32_t uptimeS;
+  uint32_t freeBytes;
+  uint32_t largestBlock;
+};
+
+// Binärformat von /diagnostics.bin (Little Endian, ohne Padding):
+//   Kopf   "SPDG" | u8 Version | u8 Tasks | u8 Verlaufseinträge
+//          u8 Flags (Bit 0: CPU-Anteil aller Tasks aus Run-Time-Stats, Bit 1: nur geschätzt)
+//          u32 uptimeS | u32 freeBytes | u32 minFreeBytes | u32 largestBlock | u32 minLargestBlock
+//          u8 Track-Slots belegt | u8 Gate-Slots belegt | u16 0
+//          u16 Auslastung je Core in ‰ (DIAG_CORE_COUNT Einträge)
+//   Task   u32 stackBytes | u32 stackFreeMin | u16 cpuPermille | u16 0          (in DiagTask-Reihenfolge)
+//   Verlauf u32 uptimeS | u32 freeBytes | u32 largestBlock                      (älteste zuerst)
+constexpr uint8_t DIAG_BINARY_VERSION = 2;
+
+extern const char* const DIAG_TASK_NAMES[DIAG_TASK_COUNT];
+
+void sampleDiagnostics();   // aus loop(); misst höchstens alle DIAG_SAMPLE_MS
+
+// Liefern die Länge (JSON ohne Nullterminator), 0 bei zu kleinem Puffer
+size_t formatDiagnosticsJson(char* out, size_t capacity);
+size_t formatDiagnosticsBinary(uint8_t* out, size_t capacity);
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "pattern_storage.h"
+
+// --------------------------------------
+// Hupen-Pattern (An/Aus-Laufzeiten)
+// --------------------------------------
+// Gemeinsame Darstellung für Pattern-Editor und Morse-Compiler; plattformunabhängig.
+// Feste Kapazität (pattern_storage.h), damit Bearbeiten keinen Heap belegt.
+
+constexpr size_t MAX_HONK_PATTERN_CHANGES = 256;
+
+enum class FirstSegment : uint8_t {FIRST_HIGH, FIRST_LOW};
+
+struct HonkPattern {
+  FirstSegment                                 first;          // FIRST_HIGH := Erste Laufzeit: Ton; FIRST_LOW := Erste Laufzeit: still
+  FixedList<uint32_t, MAX_HONK_PATTERN_CHANGES> patternChanges; // Laufzeiten in ms (wechseln immer ab zwischen Ton und Stille)
+};
@@ -4,8 +4,23 @@
 #include <ESPAsyncWebServer.h>
 #include <DNSServer.h>
 #include <WiFi.h>
+#include <driver/i2s.h>
+#include <esp_timer.h>
+#include <soc/gpio_reg.h>
+#include <soc/rtc_io_reg.h>
+#include <xtensa/core-macros.h>
 
 #include "main.h"
+#include "audio_metrics.h"
+#include "diagnostics.h"
+#include "morse.h"
+#include "persistence.h"
+#include "platform.h"
+#include "preset_bank.h"
+#include "sample_ring.h"
+#include "generated/web_assets.h"
+#include "track_format.h"
+#include "track_parser.h"
 #include "Arduino.h"
 
 // --------------------
@@ -13,178 +28,228 @@
 // --------------------
 DNSServer dnsServer;
 AsyncWebServer server(80);
+AsyncWebSocket patchSocket("/ws");   // Live-Patches aus dem Editor (track_format.h)
 
-uint8_t GPIO_SIGNAL_ENABLE_LAST_STATE;
-uint8_t GPIO_SIGNAL_SELECT_LAST_STATE;
-uint8_t GPIO_HORN_ENABLE_LAST_STATE;
-uint8_t GPIO_HONK_EMERGENCY_LAST_STATE;
 
-unsigned long GPIO_SIGNAL_ENABLE_LAST_CHANGE_TIME;
-unsigned long GPIO_SIGNAL_SELECT_LAST_CHANGE_TIME;
+HonkPattern emergencyHonkPattern = { FirstSegment::FIRST_HIGH, {25, 400, 25, 200, 20, 100, 25, 50, 25, 25, 25, 13, 25, 12, 25, 500} }; // Sollte sich bisschen bouncy anhören.
+std::atomic<GatePattern*> pendingHornGate{nullptr};
 
-unsigned long GPIO_HORN_ENABLE_LAST_CHANGE_TIME;
-unsigned long GPIO_HONK_EMERGENCY_LAST_CHANGE_TIME;
+String morseMessage;
+static MorseCompiler morseCompiler;
 
-HonkPattern emergencyHonkPattern = { FirstSegment::FIRST_HIGH, std::vector<uint32_t>{25, 400, 25, 200, 20, 100, 25, 50, 25, 25, 25, 13, 25, 12, 25, 500} }; // Sollte sich bisschen bouncy anhören.
-
-std::array<std::vector<TrackSegment>, 4> tracks = {
-  std::vector<TrackSegment>{ TrackSegment{440.0f, WaveForm::WF_SQUARE, 750, Transition::TR_NONE}, TrackSegment{587.33f, WaveForm::WF_SQUARE, 750, Transition::TR_NONE} },
-  std::vector<TrackSegment>{ TrackSegment{440.0f, WaveForm::WF_SQUARE, 750, Transition::TR_NONE}, TrackSegment{587.33f, WaveForm::WF_SQUARE, 750, Transition::TR_NONE} },
-  std::vector<TrackSegment>{ TrackSegment{441.0f, WaveForm::WF_SQUARE, 750, Transition::TR_NONE}, TrackSegment{586.33f, WaveForm::WF_SQUARE, 750, Transition::TR_NONE} },
-  std::vector<TrackSegment>{ TrackSegment{441.0f, WaveForm::WF_SQUARE, 750, Transition::TR_NONE}, TrackSegment{586.33f, WaveForm::WF_SQUARE, 750, Transition::TR_NONE} }  
-};
-std::array<std::vector<TrackSegment>, 4> synthHorn = {
-  std::vector<TrackSegment>{ TrackSegment{335.0f, WaveForm::WF_SQUARE, 10000, Transition::TR_NONE} },
-  std::vector<TrackSegment>{ TrackSegment{335.0f, WaveForm::WF_SQUARE, 10000, Transition::TR_NONE} },
-  std::vector<TrackSegment>{ TrackSegment{335.0f, WaveForm::WF_SQUARE, 10000, Transition::TR_NONE} },
-  std::vector<TrackSegment>{ TrackSegment{335.0f, WaveForm::WF_SQUARE, 10000, Transition::TR_NONE} }
-};
-
-std::array<std::vector<TrackSegment>, 4>* activeTracks = &synthHorn;
-
-volatile bool dacIsPlaying     = false;
 volatile bool stopDacRequested = false;
 
 hw_timer_t* timer = nullptr;
-
-int       currentSegmentIndices[4] = {0,0,0,0};
-uint32_t  segSamplesLeft[4]        = {0,0,0,0};
-uint32_t  segElapsedSamples[4]     = {0,0,0,0};
-float     phaseAccumulators[4]     = {0,0,0,0};
-float     phaseStep[4]             = {0,0,0,0};
-float     gainExp[4]               = {0,0,0,0};
-
-uint32_t  linearFadeSamples        = 1;
-float     invLinearFadeSamples     = 1.0f;
-float     expAlpha                 = 0.0f;
+QueueHandle_t i2sEventQueue = NULL;
 
 TaskHandle_t dacTaskHandle = NULL;
+portMUX_TYPE dacTaskMux    = portMUX_INITIALIZER_UNLOCKED;
 TaskHandle_t hornTaskHandle = NULL;
+TaskHandle_t controllerTaskHandle = NULL;
+TaskHandle_t networkTaskHandle = NULL;
+
+static BootConfig        bootConfig = {};            // aus boot.bin bzw. config.json
+static std::atomic<bool> networkReady{false};        // AP und DNS laufen (loop() bedient DNS)
 
 
 void setup() {
+  bootPhase("setup");
   Serial.begin(115200);
   pinMode(GPIO_HORN, OUTPUT);
   stopRealHorn();
 
-  pinMode(GPIO_SIGNAL_ENABLE, INPUT_PULLDOWN);
-  pinMode(GPIO_SIGNAL_SELECT, INPUT_PULLDOWN);
-
-  pinMode(GPIO_HORN_ENABLE, INPUT_PULLUP);
-  pinMode(GPIO_HONK_EMERGENCY, INPUT_PULLUP);
-
-  GPIO_SIGNAL_ENABLE_LAST_STATE = digitalRead(GPIO_SIGNAL_ENABLE);
-  GPIO_SIGNAL_SELECT_LAST_STATE = digitalRead(GPIO_SIGNAL_SELECT);
-
-  GPIO_HORN_ENABLE_LAST_STATE = digitalRead(GPIO_HORN_ENABLE);
-  GPIO_HONK_EMERGENCY_LAST_STATE = digitalRead(GPIO_HONK_EMERGENCY);
+  setupInputs();
 
-  auto now = millis();
-  GPIO_SIGNAL_ENABLE_LAST_CHANGE_TIME = now;
-  GPIO_SIGNAL_SELECT_LAST_CHANGE_TIME = now;
-  GPIO_HORN_ENABLE_LAST_CHANGE_TIME = now;
-  GPIO_HONK_EMERGENCY_LAST_CHANGE_TIME = now;
+  // Konfiguration zuerst, damit der AP auf Core 0 schon hochfährt, während hier das Audio startet
+  bool fsReady      = LittleFS.begin();
+  bool fromSnapshot = fsReady && readBootSnapshot();
+  if (!fsReady) {
+    Serial.println("Fehler: LittleFS konnte nicht eingebunden werden!");
+  } else {
+    if (!fromSnapshot) loadConfigJson();
+    bootPhase(fromSnapshot ? "Snapshot gelesen" : "JSON-Konfiguration gelesen");
+    startTask(networkTask, &networkTaskHandle, NETWORK_TASK, NETWORK_TASK_STACK, 1, 0);
+  }
 
-  dac_output_enable(DAC_CHANNEL_1);
-  dac_output_enable(DAC_CHANNEL_2);
+  setupAudioOutput();
+  initSynth();
   initTracks();
-  
-  startTask(hornTask, &hornTaskHandle, HORN_TASK);
-
-  Serial.println("DAC Synth gestartet!");
-  Serial.println("Setup finished!");
+  mountPresets();
+  bootPhase("Audio initialisiert");
+
+  if (fromSnapshot) {
+    applyBootSnapshot();
+  } else if (fsReady) {
+    loadEmergencyPattern();
+    loadHonkEmergencyPattern();
+    loadMorseMessage();
+  }
+  bootPhase("Muster geladen");
+
+  startTask(hornTask, &hornTaskHandle, HORN_TASK, HORN_TASK_STACK);
+  applyInputsAtBoot();
+  bootPhase("Signal gestartet");
+  // Über dem DAC-Task, damit ein Schalterwechsel nicht hinter einem Renderblock wartet
+  startTask(controllerTask, &controllerTaskHandle, CONTROLLER_TASK, CONTROLLER_TASK_STACK, 3);
+
+  if (fsReady) {
+    startPersistence();
+    if (!fromSnapshot) saveBootSnapshot();   // nächster Boot ohne JSON
+    if (networkTaskHandle != NULL) xTaskNotifyGive(networkTaskHandle);   // Web-Server erst mit geladenen Mustern
+  }
+  bootPhase("setup fertig");
 }
 
 void loop() {
-  // dnsServer.processNextRequest();
-  controlAudioOutput();
+  if (networkReady) {
+    dnsServer.processNextRequest();
+    patchSocket.cleanupClients();
+  }
+  reclaimRetiredTracks();
+  reclaimRetiredGate();
+  sampleDiagnostics();
+  reportBoot();
+  handleSerialCommands();
+  vTaskDelay(pdMS_TO_TICKS(LOOP_IDLE_MS));   // Eingänge laufen über den Controller-Task
 }
 
-void controlAudioOutput() {
-    bool signalEnabledChanged = debouncedInputHasChanged(GPIO_SIGNAL_ENABLE, GPIO_SIGNAL_ENABLE_LAST_CHANGE_TIME, GPIO_SIGNAL_ENABLE_LAST_STATE);
-    bool signalEnabled = signalIsEnabled();  
-    
-    if (signalEnabledChanged && !signalEnabled) {
-      stopRealHorn();
-      killTask(dacTaskHandle);
-      return;
-    }
-    
-    if (!(signalEnabledChanged || signalEnabled)) {
-      return;
-    }
+// --------------------
+// Boot-Zeitmessung
+// --------------------
+struct BootPhase {
+  const char*           name;
+  std::atomic<uint32_t> us;   // 0 = noch nicht geschrieben
+};
 
-    updateAcousticSignal();
+static BootPhase            bootPhases[BOOT_PHASE_MAX];
+static std::atomic<uint8_t> bootPhaseCount{0};
 
+// Aus setup() und dem Network-Task; nur Zeitstempel merken, ausgegeben wird in loop()
+void bootPhase(const char* name) {
+  uint8_t index = bootPhaseCount.fetch_add(1);
+  if (index >= BOOT_PHASE_MAX) return;
+  uint32_t now = (uint32_t)esp_timer_get_time();
+  bootPhases[index].name = name;
+  bootPhases[index].us.store(now > 0 ? now : 1);
 }
 
-void updateAcousticSignal() {
-  bool selectionHasChanged = debouncedInputHasChanged(GPIO_SIGNAL_SELECT, GPIO_SIGNAL_SELECT_LAST_CHANGE_TIME, GPIO_SIGNAL_SELECT_LAST_STATE);
-  bool emergencySignalSelectionHasChanged = debouncedInputHasChanged(GPIO_HONK_EMERGENCY, GPIO_HONK_EMERGENCY_LAST_CHANGE_TIME, GPIO_HONK_EMERGENCY_LAST_STATE);
-   
-  if (selectionHasChanged && !emergencyIsSelected()) {
-    honk();
-  } else if (emergencyIsSelected() && (selectionHasChanged || emergencySignalSelectionHasChanged)) {
-    emergencySignal();
+void reportBoot() {
+  static uint8_t printed         = 0;
+  static bool    firstSoundShown = false;
+
+  while (printed < BOOT_PHASE_MAX && bootPhases[printed].us.load() != 0) {
+    Serial.printf("Boot %8.1f ms  %s\n", bootPhases[printed].us.load() / 1000.0f, bootPhases[printed].name);
+    printed++;
+  }
+  // Bei abgeschaltetem Signal erst mit dem ersten Einschalten
+  uint32_t firstSound = audioMetrics.firstSoundUs;
+  if (!firstSoundShown && firstSound != 0) {
+    Serial.printf("Boot: erstes hörbares Sample nach %.1f ms\n", firstSound / 1000.0f);
+    firstSoundShown = true;
   }
 }
 
-bool debouncedInputHasChanged(uint8_t input, unsigned long &lastChange, uint8_t &lastState) {
-  if (millis() < lastChange + DEBOUNCE_MS) return false;
-
-  uint8_t reading = digitalRead(input);
-  if (reading == lastState) return false;
-
-  lastState = reading;
-  lastChange = millis();
-  return true;
+// Einzeichen-Befehle über den Serial-Monitor: m = Audio-Metriken ausgeben, r = zurücksetzen,
+// d = Speicher-/Task-Diagnose (JSON)
+void handleSerialCommands() {
+  static char text[DIAG_TEXT_SIZE > METRICS_TEXT_SIZE ? DIAG_TEXT_SIZE : METRICS_TEXT_SIZE];
+  while (Serial.available() > 0) {
+    int command = Serial.read();
+    if (command == 'm') {
+      size_t len = formatAudioMetrics(text, sizeof(text));
+      Serial.write((const uint8_t*)text, len);
+    } else if (command == 'r') {
+      resetAudioMetrics();
+      Serial.println("Audio-Metriken zurückgesetzt.");
+    } else if (command == 'd') {
+      size_t len = formatDiagnosticsJson(text, sizeof(text));
+      Serial.write((const uint8_t*)text, len);
+    }
+  }
 }
 
-bool signalIsEnabled() {
-  return digitalRead(GPIO_SIGNAL_ENABLE) == HIGH;
+// --------------------
+// Eingänge
+// --------------------
+static inline uint8_t IRAM_ATTR readPinFromIsr(uint8_t pin) {
+  // digitalRead liegt im Flash; GPIO 32..39 stehen im zweiten Eingangsregister
+  return pin < 32 ? (REG_READ(GPIO_IN_REG) >> pin) & 1 : (REG_READ(GPIO_IN1_REG) >> (pin - 32)) & 1;
 }
 
-bool emergencyIsSelected() {
-  return digitalRead(GPIO_SIGNAL_SELECT) == LOW;
+// Von der ISR gesetzt, vom Controller-Task übernommen (takeInputEdges())
+static volatile bool     edgePending[INPUT_COUNT] = {};
+static volatile uint32_t edgeFirstUs[INPUT_COUNT] = {};   // gilt, solange edgePending
+
+static void IRAM_ATTR onInputEdge(void* arg) {
+  uint8_t input = (uint8_t)(uintptr_t)arg;
+  uint32_t now = (uint32_t)esp_timer_get_time();
+  inputs[input].lastEdgeUs = now;
+  if (!edgePending[input]) {
+    edgeFirstUs[input] = now;
+    edgePending[input] = true;
+  }
+
+  // Nur Wecker: vor dem Start des Controller-Tasks bleibt die Flanke in edgePending liegen
+  if (controllerTaskHandle == NULL) return;
+  BaseType_t woken = pdFALSE;
+  vTaskNotifyGiveFromISR(controllerTaskHandle, &woken);
+  if (woken) portYIELD_FROM_ISR();
 }
 
-bool synthesizeHorn() {
-  return digitalRead(GPIO_HORN_ENABLE) == HIGH;
+void setupInputs() {
+  pinMode(GPIO_SIGNAL_ENABLE, INPUT_PULLDOWN);
+  pinMode(GPIO_SIGNAL_SELECT, INPUT_PULLDOWN);
+
+  pinMode(GPIO_HORN_ENABLE, INPUT_PULLUP);
+  pinMode(GPIO_HONK_EMERGENCY, INPUT_PULLUP);
+
+  pinMode(GPIO_PRESET_BIT0, INPUT_PULLUP);
+  pinMode(GPIO_PRESET_BIT1, INPUT_PULLUP);
+  pinMode(GPIO_PRESET_BIT2, INPUT_PULLUP);
+
+  for (uint8_t i = 0; i < INPUT_COUNT; ++i) {
+    inputs[i].state        = digitalRead(inputs[i].pin);
+    inputs[i].handledState = inputs[i].state;
+    inputs[i].settling     = false;
+    attachInterruptArg(inputs[i].pin, onInputEdge, (void*)(uintptr_t)i, CHANGE);
+  }
 }
 
-bool useHornForEmergencySignal() {
-  return digitalRead(GPIO_HONK_EMERGENCY) == LOW;
+uint8_t readInputPin(uint8_t pin) {
+  return digitalRead(pin);
 }
 
-void honk() {
-  if (synthesizeHorn()) {
-    activeTracks = &synthHorn;
-    if (dacTaskHandle == NULL) startTask(dacTask, &dacTaskHandle, DAC_TASK);
-    else (resumeTask(dacTaskHandle));
-  } else {
-    playRealHorn();
+// Flanken seit dem letzten Aufruf an die Entprellung geben. Kommt währenddessen eine neue, setzt
+// die ISR nur lastEdgeUs – der Eingang prellt dann ohnehin schon und wird erst nach der Ruhezeit gelesen.
+static void takeInputEdges() {
+  for (uint8_t i = 0; i < INPUT_COUNT; ++i) {
+    if (!edgePending[i]) continue;
+    uint32_t firstUs = edgeFirstUs[i];
+    edgePending[i] = false;
+    noteInputEdge(i, firstUs);
   }
 }
 
-void emergencySignal() {
-  if (useHornForEmergencySignal()) {
-    startTask(hornTask, &hornTaskHandle, HORN_TASK);
-  } else {
-    activeTracks = &tracks;
-    startTask(dacTask, &dacTaskHandle, DAC_TASK);
+void controllerTask(void* parameter) {
+  while (true) {
+    takeInputEdges();
+
+    uint32_t firstEdgeUs = 0;
+    uint32_t waitUs;
+    bool changed = settleInputs((uint32_t)esp_timer_get_time(), waitUs, firstEdgeUs);
+    if (changed) {
+      controlAudioOutput();
+      metricsRecordSwitch((uint32_t)esp_timer_get_time() - firstEdgeUs);
+    }
 
+    // Schlafen bis zur nächsten Flanke oder bis die Ruhezeit des ersten prellenden Eingangs um ist
+    ulTaskNotifyTake(pdTRUE, waitUs == UINT32_MAX ? portMAX_DELAY : pdMS_TO_TICKS((waitUs + 999) / 1000) + 1);
   }
 }
 
 void playRealHorn() {
   digitalWrite(GPIO_HORN, LOW);
-}
-
-void stopHonk() {
-  if (synthesizeHorn()) {
-    pauseTask(dacTaskHandle);
-  }
-  stopRealHorn();
+  metricsRecordFirstSound((uint32_t)esp_timer_get_time());
 }
 
 void stopRealHorn() {
@@ -192,348 +257,1036 @@ void stopRealHorn() {
 }
 
 void doConfig() {
-  String json = readFile("/config/config.json");
-  if(json == "") return;
-  
-  JsonDocument config;
-  DeserializationError error = deserializeJson(config, json.c_str());
-  
-  if(error){
-    Serial.print("JSON Parsing Error: ");
-    Serial.println(error.c_str());
-    return;
-  }
-  
-  const char* ssid = config["wifi"]["ssid"];
-  const char* password = config["wifi"]["pw"];
-  
-  const char* domain = config["domain"];
-  
+  if (bootConfig.ssid[0] == '\0') return;   // keine Konfiguration: kein AP
+  const char* ssid     = bootConfig.ssid;
+  const char* password = bootConfig.password;
+
   if (strlen(password) < 8) {
     WiFi.softAP(ssid);
   } else {
     WiFi.softAP(ssid, password);
   }
-  
+
   Serial.println("Access Point started");
   Serial.print("IP Address: ");
   IPAddress ip = WiFi.softAPIP();
   Serial.println(ip);
   Serial.println("SSID: " + String(ssid));
   Serial.println("Passwort: " + String(password));
-  
-  
-  dnsServer.start(53, domain, ip);
-}
 
-static inline uint32_t msToSamples(uint32_t ms) {
-  // Mindestens 1 Sample, um 0-Dauern zu vermeiden
-  uint32_t s = (uint32_t)((uint64_t)ms * SAMPLE_RATE / 1000ULL);
-  return s == 0 ? 1u : s;
+  dnsServer.start(53, bootConfig.domain, ip);
 }
 
-static inline void updatePhaseStep(int trackIdx, float freq) {
-  // Bei extrem hohen Frequenzen bleibt der Code stabil; Phase wird unten sauber gewrappt
-  phaseStep[trackIdx] = 2.0f * (float)M_PI * freq / (float)SAMPLE_RATE;
+// Core 0, nur beim Booten: AP und DNS parallel zur Audio-Initialisierung auf Core 1. Der Web-Server
+// startet erst, wenn setup() die Muster geladen hat (Benachrichtigung), damit kein Request einen
+// halb initialisierten Zustand sieht.
+void networkTask(void* parameter) {
+  doConfig();
+  networkReady = true;
+  bootPhase("AP und DNS bereit");
+
+  ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+  setupServer();
+  bootPhase("Web-Server bereit");
+
+  networkTaskHandle = NULL;
+  vTaskDelete(NULL);
 }
 
-static inline float generateWave(WaveForm waveForm, float phase) {
-  // Liefert -1..+1
-  switch (waveForm) {
-    case WaveForm::WF_SINE:
-      return sinf(phase);
-    case WaveForm::WF_SQUARE:
-      return sinf(phase) >= 0.0f ? 1.0f : -1.0f;
-    case WaveForm::WF_SAW: {
-      // 0..2pi -> -1..+1 (ansteigende Säge)
-      float x = phase / (float)M_PI;   // 0..2
-      return x - 1.0f;                 // -1..+1
-    }
-    case WaveForm::WF_TRI: {
-      // Dreieck aus Phase (0..2pi)
-      float t = phase / (2.0f * (float)M_PI);    // 0..1
-      float tri = 2.0f * fabsf(2.0f * (t - floorf(t + 0.5f))) - 1.0f; // -1..1
-      return -tri; // invertiert für Phasenanpassung zu Sinus
-    }
-    default:
-      return 0.0f;
+// --------------------
+// Persistenz
+// --------------------
+// Laden passiert einmal beim Booten (vor startPersistence): aus boot.bin, nur ohne gültigen Snapshot
+// aus den Einzeldateien. Speichern legt nur den neuen Stand in der Persistenz-Queue ab (Einzeldatei
+// und Snapshot), geschrieben wird im Writer-Task (persistence.h).
+
+// --- Hupen-Pattern ---
+static String honkPatternJson;   // aktueller Stand als JSON (GET /pattern, Datei)
+
+// --- JSON-Arena ---
+// ArduinoJson legt seine Pools sonst für jedes Dokument auf dem Heap an. Die Pattern-Dokumente
+// (Laden, /pattern) nutzen stattdessen einen festen Puffer, der pro Dokument von vorn beginnt.
+// Es lebt immer nur eines gleichzeitig (setup() bzw. der async_tcp-Task).
+class JsonArena : public ArduinoJson::Allocator {
+ public:
+  void reset() { used = 0; last = NONE; }
+
+  void* allocate(size_t size) override {
+    size_t need = blockSize(size);
+    if (need > JSON_ARENA_SIZE - used) return nullptr;   // ArduinoJson meldet dann NoMemory
+    Header* block = (Header*)(buffer + used);
+    block->size = size;
+    last        = used;
+    used       += need;
+    return block + 1;
   }
-}
 
-void normalizeTrackLengths(std::array<std::vector<TrackSegment>, 4>& tracks) {
-    // 1. Gesamtdauer pro Track berechnen
-    std::array<uint16_t, 4> trackDurations = {0,0,0,0};
-    for (int i = 0; i < 4; ++i) {
-        for (const auto& seg : tracks[i]) {
-            trackDurations[i] += seg.duration;
-        }
+  void deallocate(void* ptr) override {
+    // Nur der zuletzt vergebene Block wird sofort zurückgenommen, der Rest mit reset()
+    if (ptr != nullptr && (uint8_t*)((Header*)ptr - 1) == buffer + last) {
+      used = last;
+      last = NONE;
     }
+  }
 
-    // 2. Längsten Track finden
-    uint16_t maxDuration = 0;
-    for (int i = 0; i < 4; ++i) {
-        if (trackDurations[i] > maxDuration) {
-            maxDuration = trackDurations[i];
-        }
+  void* reallocate(void* ptr, size_t size) override {
+    if (ptr == nullptr) return allocate(size);
+    Header* block = (Header*)ptr - 1;
+    if ((uint8_t*)block == buffer + last) {   // letzter Block: an Ort und Stelle ändern
+      if (blockSize(size) > JSON_ARENA_SIZE - last) return nullptr;
+      block->size = size;
+      used        = last + blockSize(size);
+      return ptr;
     }
+    if (size <= block->size) return ptr;      // verkleinern: Platz bleibt bis reset() belegt
+    void* moved = allocate(size);
+    if (moved != nullptr) memcpy(moved, ptr, block->size);
+    return moved;
+  }
 
-    // 3. Jeden Track auffüllen
-    for (int i = 0; i < 4; ++i) {
-        uint16_t diff = maxDuration - trackDurations[i];
-        if (diff > 0) {
-            // Stille-Segment einfügen (Frequenz 0)
-            tracks[i].push_back(TrackSegment{0.0f, WaveForm::WF_SQUARE, diff, Transition::TR_NONE});
-        }
-    }
-}
+ private:
+  struct Header { size_t size; size_t reserved; };   // hält die Nutzdaten 8-Byte-ausgerichtet
+  static constexpr size_t NONE = SIZE_MAX;
 
-void playDacSample() {
-  float mix = 0.0f;
-
-  for (int t = 0; t < 4; ++t) {
-    if ((*activeTracks)[t].empty() || segSamplesLeft[t] <= 0) continue;
-
-    int segIdx = currentSegmentIndices[t];
-    const TrackSegment& seg = (*activeTracks)[t][segIdx];
-
-    // Waveform
-    float s = generateWave(seg.waveForm, phaseAccumulators[t]);
-
-    float g = 1.0f;
-    switch (seg.transition) {
-      case Transition::TR_LINEAR:
-        if (segElapsedSamples[t] < linearFadeSamples)
-          g = (float)segElapsedSamples[t] * invLinearFadeSamples;
-        else
-          g = 1.0f;
-        break;
-      case Transition::TR_EXP:
-        // One-pole Richtung 1.0
-        gainExp[t] += (1.0f - gainExp[t]) * expAlpha;
-        if (gainExp[t] > 1.0f) gainExp[t] = 1.0f;
-      g = gainExp[t];
-        break;
-      case Transition::TR_NONE:
-      default:
-        g = 1.0f;
-        break;
-    }
+  static size_t blockSize(size_t size) { return sizeof(Header) + ((size + 7) & ~(size_t)7); }
 
-    mix += s * g;
+  alignas(8) uint8_t buffer[JSON_ARENA_SIZE];
+  size_t             used = 0;
+  size_t             last = NONE;
+};
 
-    // Phase advance
-    phaseAccumulators[t] += phaseStep[t];
-    // Mehrfach-Wrap verhindern (bei sehr hoher freq)
-    if (phaseAccumulators[t] >= 2.0f * (float)M_PI) {
-      phaseAccumulators[t] = fmodf(phaseAccumulators[t], 2.0f * (float)M_PI);
-    }
+static JsonArena jsonArena;
 
-    segElapsedSamples[t]++;
-    segSamplesLeft[t]--;
-
-    // Segmentwechsel
-    if (segSamplesLeft[t] == 0) {
-      segIdx = (segIdx + 1) % (*activeTracks)[t].size();
-      currentSegmentIndices[t] = segIdx;
-      segElapsedSamples[t] = 0;
-      phaseAccumulators[t] = 0.0f;
-
-      if (!(*activeTracks)[t].empty()) {
-        const TrackSegment& nextSeg = (*activeTracks)[t][segIdx];
-        segSamplesLeft[t] = msToSamples(nextSeg.duration);
-        updatePhaseStep(t, nextSeg.freq);
-        gainExp[t] = (nextSeg.transition == Transition::TR_EXP) ? 0.001f : 1.0f;
-      }
-    }
-  }
-  
-  // Normalize + Output
-    mix /= activeTracks->size();
-  int val = (int)(mix * 127.0f + 128.0f);
-  if (val < 0) val = 0; else if (val > 255) val = 255;
+static String honkPatternToJson(const HonkPattern& pattern) {
+  jsonArena.reset();
+  JsonDocument doc(&jsonArena);
+  doc["first"] = pattern.first == FirstSegment::FIRST_HIGH ? "HIGH" : "LOW";
+  JsonArray changes = doc["patternChanges"].to<JsonArray>();
+  for (uint32_t duration : pattern.patternChanges) changes.add(duration);
 
-  dac_output_voltage(DAC_CHANNEL_1, (uint8_t)val);
-  dac_output_voltage(DAC_CHANNEL_2, (uint8_t)val);
+  String json;
+  serializeJson(doc, json);
+  return json;
 }
 
+static bool honkPatternFromJson(const char* json, size_t len, HonkPattern& out) {
+  jsonArena.reset();
+  JsonDocument doc(&jsonArena);
+  DeserializationError error = deserializeJson(doc, json, len);
+  if (error) {
+    Serial.print("Pattern-JSON fehlerhaft: ");
+    Serial.println(error.c_str());
+    return false;
+  }
+
+  JsonArray changes = doc["patternChanges"].as<JsonArray>();
+  if (changes.isNull() || changes.size() > MAX_HONK_PATTERN_CHANGES) return false;
+
+  const char* first = doc["first"] | "HIGH";
+  out.first = strcmp(first, "LOW") == 0 ? FirstSegment::FIRST_LOW : FirstSegment::FIRST_HIGH;
+  out.patternChanges.clear();
+  for (JsonVariant duration : changes) {
+    uint32_t ms = duration.as<uint32_t>();
+    out.patternChanges.push_back(ms > 0 ? ms : 1);
+  }
+  return true;
+}
 
 void loadHonkEmergencyPattern() {
+  if (!LittleFS.exists(HONK_PATTERN_FILE)) {
+    Serial.println("pattern.json existiert nicht.");
+    honkPatternJson = honkPatternToJson(emergencyHonkPattern);
+    return;
+  }
+
+  String json = readFile(HONK_PATTERN_FILE);
+  if (!honkPatternFromJson(json.c_str(), json.length(), emergencyHonkPattern)) {
+    Serial.println("Fehler: pattern.json ist ungültig!");
+  } else {
+    persistLoaded(PersistFile::HONK_PATTERN, (const uint8_t*)json.c_str(), json.length());
+  }
+  honkPatternJson = honkPatternToJson(emergencyHonkPattern);
 }
 
 void saveHonkEmergencyPattern() {
+  honkPatternJson = honkPatternToJson(emergencyHonkPattern);
+  persistLater(PersistFile::HONK_PATTERN, (const uint8_t*)honkPatternJson.c_str(), honkPatternJson.length());
+  saveBootSnapshot();
+
+  if (honkPatternActive) startHonkPattern();   // neues Muster sofort, von vorn
+}
+
+// --- Nutzer-Tracks (Binärformat, siehe track_format.h) ---
+// Zuletzt geladener/gespeicherter Stand als tracks.bin-Bytes, für den Snapshot; 0 = Vorgabe-Tracks
+static uint8_t tracksBinary[TRACKS_BINARY_MAX_SIZE];
+static size_t  tracksBinaryLen = 0;
+
+static bool restoreTracks(const uint8_t* data, size_t len) {
+  TrackSet* loaded = acquireTrackSet();
+  if (loaded == nullptr) {
+    Serial.println("Fehler: kein freier Track-Slot!");
+    return false;
+  }
+  if (!decodeTracksBinary(data, len, *loaded)) {
+    releaseTrackSet(loaded);
+    return false;
+  }
+  if (data != tracksBinary) memcpy(tracksBinary, data, len);
+  tracksBinaryLen = len;
+  compileTimeline(*loaded);
+  publishTracks(loaded);
+  return true;
 }
 
 void loadEmergencyPattern() {
+  File f = LittleFS.open(TRACKS_FILE, "r");
+  if (!f) {
+    Serial.println("tracks.bin existiert nicht.");
+    return;
+  }
+
+  size_t len = f.read(tracksBinary, sizeof(tracksBinary));
+  f.close();
+
+  if (!restoreTracks(tracksBinary, len)) {
+    Serial.println("Fehler: tracks.bin ist ungültig!");
+    return;
+  }
+  persistLoaded(PersistFile::TRACKS, tracksBinary, len);
 }
 
-void saveEmergencyPattern() {
+void saveEmergencyPattern(const TrackSet& set) {
+  size_t len = encodeTracksBinary(set, tracksBinary, sizeof(tracksBinary));
+  if (len == 0) return;
+
+  tracksBinaryLen = len;
+  persistLater(PersistFile::TRACKS, tracksBinary, len);
+  saveBootSnapshot();
+}
+
+// Live-Patch: Spiegel und Dateien sofort, der Audio-Pfad übernimmt an der nächsten passenden
+// Segmentgrenze. Läuft im async_tcp-Task wie die übrigen Handler.
+static PatchStatus applySegmentPatch(const SegmentPatch& patch) {
+  // Ohne Spiegel spielen noch die Vorgabe-Tracks; bis zum ersten Patch schreibt niemand hinein
+  if (tracksBinaryLen == 0) tracksBinaryLen = encodeTracksBinary(tracks, tracksBinary, sizeof(tracksBinary));
+
+  if (patch.track >= TRACK_COUNT || !tracksBinaryHasSegment(tracksBinary, tracksBinaryLen, patch.track, patch.segment)) {
+    return PatchStatus::BAD_SEGMENT;
+  }
+  if (!queueSegmentPatch(patch)) return PatchStatus::BUSY;
+
+  patchTracksBinary(tracksBinary, tracksBinaryLen, patch);
+  persistLater(PersistFile::TRACKS, tracksBinary, tracksBinaryLen);
+  saveBootSnapshot();
+  return PatchStatus::OK;
+}
+
+// --- Konfiguration (nur ohne gültigen Snapshot) ---
+bool loadConfigJson() {
+  if (!LittleFS.exists(CONFIG_FILE)) return false;
+  String json = readFile(CONFIG_FILE);
+  if (json == "") return false;
+
+  jsonArena.reset();
+  JsonDocument config(&jsonArena);
+  DeserializationError error = deserializeJson(config, json.c_str(), json.length());
+  if (error) {
+    Serial.print("JSON Parsing Error: ");
+    Serial.println(error.c_str());
+    return false;
+  }
+
+  strlcpy(bootConfig.ssid,     config["wifi"]["ssid"] | "", sizeof(bootConfig.ssid));
+  strlcpy(bootConfig.password, config["wifi"]["pw"] | "",   sizeof(bootConfig.password));
+  strlcpy(bootConfig.domain,   config["domain"] | "",       sizeof(bootConfig.domain));
+  return true;
+}
+
+// --- Boot-Snapshot (siehe boot_snapshot.h) ---
+// Puffer und Struktur dienen beim Booten dem Lesen, danach dem Schreiben (async_tcp-Task); beides
+// passiert nie gleichzeitig
+static uint8_t      snapshotBuffer[BOOT_SNAPSHOT_MAX_SIZE];
+static BootSnapshot snapshot;
+
+bool readBootSnapshot() {
+  File f = LittleFS.open(BOOT_SNAPSHOT_FILE, "r");
+  if (!f) return false;
+  size_t len = f.read(snapshotBuffer, sizeof(snapshotBuffer));
+  f.close();
+
+  if (!decodeBootSnapshot(snapshotBuffer, len, snapshot)) {
+    Serial.println("boot.bin ist ungültig, lade die Einzeldateien.");
+    return false;
+  }
+  persistLoaded(PersistFile::BOOT_SNAPSHOT, snapshotBuffer, len);
+  if (snapshot.hasConfig) bootConfig = snapshot.config;
+  return true;
+}
+
+// Nach initTracks(); fehlende Abschnitte lassen die Vorgabe stehen
+void applyBootSnapshot() {
+  if (snapshot.tracks != nullptr && !restoreTracks(snapshot.tracks, snapshot.tracksLen)) {
+    Serial.println("Fehler: Tracks im Snapshot sind ungültig!");
+  }
+  if (snapshot.hasHonkPattern) emergencyHonkPattern = snapshot.honkPattern;
+  honkPatternJson = honkPatternToJson(emergencyHonkPattern);
+  if (snapshot.morse != nullptr) {
+    morseMessage = "";
+    morseMessage.concat(snapshot.morse, snapshot.morseLen);
+    morseCompiler.compile(morseMessage.c_str(), morseMessage.length(), MORSE_DIT_MS);
+  }
+}
+
+// Aktueller Stand aller Dateien. Passt er nicht (sehr lange Morse-Nachricht), wird boot.bin geleert;
+// der nächste Boot liest dann die Einzeldateien.
+void saveBootSnapshot() {
+  snapshot.hasConfig      = bootConfig.ssid[0] != '\0';
+  snapshot.config         = bootConfig;
+  snapshot.hasHonkPattern = true;
+  snapshot.honkPattern    = emergencyHonkPattern;
+  snapshot.morse          = morseMessage.length() > 0 ? morseMessage.c_str() : nullptr;
+  snapshot.morseLen       = morseMessage.length();
+  snapshot.tracks         = tracksBinaryLen > 0 ? tracksBinary : nullptr;
+  snapshot.tracksLen      = tracksBinaryLen;
+
+  size_t len = encodeBootSnapshot(snapshot, snapshotBuffer, sizeof(snapshotBuffer));
+  persistLater(PersistFile::BOOT_SNAPSHOT, snapshotBuffer, len);
+}
+
+// --- Preset-Bank (Flash-Partition, siehe preset_bank.h) ---
+void mountPresets() {
+  size_t size;
+  const uint8_t* image = platformMapReadOnly(PRESET_BANK_PARTITION, size);
+  if (image == nullptr) {
+    Serial.println("Keine Preset-Partition.");
+  } else if (!mountPresetBank(image, size)) {
+    Serial.println("Preset-Partition enthält keine gültige Bank.");
+  } else {
+    Serial.printf("Preset-Bank: %u Presets\n", (unsigned)presetCount());
+  }
+  choosePreset(presetFromInputs());
 }
 
 // --- Morse Load/Save ---
 void loadMorseMessage() {
-  if (LittleFS.exists("/morseMessage.txt")) {
-    File f = LittleFS.open("/morseMessage.txt", "r");
-    if (!f) {
-      Serial.println("Fehler: konnte morseMessage.txt nicht öffnen!");
-      return;
-    }
-    
-    // morseMessage = f.readString();
-    f.close();
-    // Serial.println("morseMessage.txt geladen: " + morseMessage);
-  } else {
+  if (!LittleFS.exists(MORSE_MESSAGE_FILE)) {
     Serial.println("morseMessage.txt existiert nicht.");
+    return;
   }
+
+  morseMessage = readFile(MORSE_MESSAGE_FILE);
+  persistLoaded(PersistFile::MORSE_MESSAGE, (const uint8_t*)morseMessage.c_str(), morseMessage.length());
+  const HonkPattern& compiled = morseCompiler.compile(morseMessage.c_str(), morseMessage.length(), MORSE_DIT_MS);
+  Serial.printf("morseMessage.txt geladen: %s (%u Laufzeiten)\n", morseMessage.c_str(), (unsigned)compiled.patternChanges.size());
 }
 
 void saveMorseMessage() {
-  File f = LittleFS.open("/morseMessage.txt", "w");
-  // f.print(morseMessage);
-  f.close();
+  persistLater(PersistFile::MORSE_MESSAGE, (const uint8_t*)morseMessage.c_str(), morseMessage.length());
+  saveBootSnapshot();
 }
 
 // --- Endpoints ---
+void sendWebAsset(AsyncWebServerRequest* request, const WebAsset& asset) {
+  // Unverändert → 304 ohne Body
+  if (request->hasHeader("If-None-Match")
+      && strstr(request->getHeader("If-None-Match")->value().c_str(), asset.etag) != nullptr) {
+    AsyncWebServerResponse* response = request->beginResponse(304);
+    response->addHeader("ETag", asset.etag);
+    request->send(response);
+    return;
+  }
+
+  // Direkt aus dem Flash (Firmware-Array), bereits gzip-komprimiert
+  AsyncWebServerResponse* response = request->beginResponse_P(200, asset.contentType, asset.data, asset.length);
+  response->addHeader("Content-Encoding", "gzip");
+  response->addHeader("ETag", asset.etag);
+  response->addHeader("Cache-Control", "no-cache");   // immer revalidieren, dank ETag meist nur 304
+  request->send(response);
+}
+
+// --- Request-Bodies ---
+// async_tcp ruft Body- und Request-Handler nacheinander in einem Task auf, daher genügt je
+// Endpunkt ein statischer Zustand. Die Handler parsen und reihen nur ein, sie schreiben nie Flash.
+struct BodyBuffer {
+  AsyncWebServerRequest* request;
+  String                 text;
+  bool                   complete;
+};
+
+static BodyBuffer patternBody = { nullptr, String(), false };
+static BodyBuffer morseBody   = { nullptr, String(), false };
+
+// Kleine Bodies (Pattern, Morse) vollständig sammeln
+static void collectBody(BodyBuffer& body, AsyncWebServerRequest* request, const uint8_t* data, size_t len, size_t index, size_t total) {
+  if (index == 0) {
+    body.request  = request;
+    body.complete = false;
+    body.text     = "";
+    if (total <= PERSIST_TEXT_MAX_SIZE) body.text.reserve(total);
+  }
+  if (body.request != request || total > PERSIST_TEXT_MAX_SIZE) return;
+
+  body.text.concat((const char*)data, len);
+  if (index + len == total) body.complete = true;
+}
+
+static bool takeBody(BodyBuffer& body, AsyncWebServerRequest* request) {
+  bool ok = body.request == request && body.complete;
+  body.request  = nullptr;
+  body.complete = false;
+  return ok;
+}
+
+// Track-Upload wird direkt aus den Body-Stücken geparst, ohne den Body zu puffern. Ziel ist ein
+// Slot aus dem Track-Pool; ist keiner frei (Audio-Pfad hat den vorigen Upload noch nicht
+// übernommen), wird der Upload mit 503 abgelehnt.
+static TrackSet*              speakerUpload        = nullptr;
+static AsyncWebServerRequest* speakerUploadRequest = nullptr;
+static bool                   speakerUploadOk      = false;
+static TrackJsonParser        speakerParser;
+
+static void onSpeakerDataBody(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) {
+  if (index == 0) {
+    if (speakerUpload == nullptr) speakerUpload = acquireTrackSet();
+    speakerUploadRequest = request;
+    speakerUploadOk      = false;
+    if (speakerUpload == nullptr) return;
+    speakerParser.begin(*speakerUpload);
+  }
+  if (request != speakerUploadRequest || speakerUpload == nullptr) return;
+
+  speakerParser.feed((const char*)data, len);
+  if (index + len == total) speakerUploadOk = speakerParser.finish();
+}
+
+static void onSpeakerDataRequest(AsyncWebServerRequest* request) {
+  bool ok = request == speakerUploadRequest && speakerUploadOk;
+  speakerUploadRequest = nullptr;
+  speakerUploadOk      = false;
+  if (speakerUpload == nullptr) {
+    request->send(503, "text/plain", "Vorheriger Satz wird noch übernommen");
+    return;
+  }
+  if (!ok) {
+    request->send(400, "text/plain", speakerParser.failed() ? speakerParser.error() : "Tracks unvollständig");
+    return;
+  }
+
+  // Satz geht an den Audio-Pfad über; der nächste Upload bekommt einen neuen Slot
+  TrackSet* next = speakerUpload;
+  speakerUpload = nullptr;
+  updateDacSettings(next);
+  request->send(200);
+}
+
+// Nur vollständige Binär-Frames in einem Stück; ein Patch ist höchstens PATCH_MESSAGE_MAX_SIZE Bytes
+static void onPatchSocketEvent(AsyncWebSocket* socket, AsyncWebSocketClient* client, AwsEventType type, void* arg, uint8_t* data, size_t len) {
+  if (type != WS_EVT_DATA) return;
+  const AwsFrameInfo* info = (const AwsFrameInfo*)arg;
+  if (!info->final || info->index != 0 || info->len != len || info->opcode != WS_BINARY) return;
+
+  SegmentPatch patch;
+  uint32_t     version = 0;
+  PatchStatus  status  = decodePatchMessage(data, len, patch, version) ? applySegmentPatch(patch) : PatchStatus::BAD_MESSAGE;
+
+  uint8_t ack[PATCH_ACK_SIZE];
+  encodePatchAck(status, version, ack);
+  client->binary(ack, sizeof(ack));
+}
+
 void setupServer() {
+  for (size_t i = 0; i < WEB_ASSET_COUNT; ++i) {
+    const WebAsset& asset = WEB_ASSETS[i];
+    server.on(asset.path, HTTP_GET, [&asset](AsyncWebServerRequest* request) {
+      sendWebAsset(request, asset);
+    });
+  }
+  server.on("/", HTTP_GET, [](AsyncWebServerRequest* request) {
+    sendWebAsset(request, WEB_ASSETS[0]);
+  });
+
+  server.on("/saveSpeakerData", HTTP_POST, onSpeakerDataRequest, nullptr, onSpeakerDataBody);
+  patchSocket.onEvent(onPatchSocketEvent);
+  server.addHandler(&patchSocket);
+
+  server.on("/metrics", HTTP_GET, [](AsyncWebServerRequest* request) {
+    static char text[METRICS_TEXT_SIZE];
+    formatAudioMetrics(text, sizeof(text));
+    request->send(200, "text/plain; version=0.0.4", text);
+  });
+
+  server.on("/diagnostics", HTTP_GET, [](AsyncWebServerRequest* request) {
+    static char text[DIAG_TEXT_SIZE];
+    formatDiagnosticsJson(text, sizeof(text));
+    request->send(200, "application/json", text);
+  });
+
+  server.on("/diagnostics.bin", HTTP_GET, [](AsyncWebServerRequest* request) {
+    static uint8_t data[DIAG_BINARY_SIZE];
+    size_t len = formatDiagnosticsBinary(data, sizeof(data));
+    AsyncResponseStream* response = request->beginResponseStream("application/octet-stream");
+    response->write(data, len);
+    request->send(response);
+  });
+
+  // {"selected":-1,"presets":["name",...]}; Namen prüft mountPresetBank() (kein Escaping nötig)
+  server.on("/presets", HTTP_GET, [](AsyncWebServerRequest* request) {
+    AsyncResponseStream* response = request->beginResponseStream("application/json");
+    response->printf("{\"selected\":%d,\"presets\":[", selectedPreset.load());
+    for (size_t i = 0; i < presetCount(); ++i) response->printf("%s\"%s\"", i ? "," : "", presetName(i));
+    response->print("]}");
+    request->send(response);
+  });
+  // index=n oder name=...; index=-1 wählt wieder den Nutzersatz
+  server.on("/preset", HTTP_POST, [](AsyncWebServerRequest* request) {
+    int index = request->hasArg("name") ? findPreset(request->arg("name").c_str())
+                                        : (request->hasArg("index") ? request->arg("index").toInt() : -2);
+    if (index < -1 || index >= (int)presetCount()) {
+      request->send(404, "text/plain", "Preset unbekannt");
+      return;
+    }
+    choosePreset(index);
+    request->send(200);
+  });
+
+  server.on("/pattern", HTTP_GET, [](AsyncWebServerRequest* request) {
+    request->send(200, "application/json", honkPatternJson);
+  });
+  server.on("/pattern", HTTP_POST, [](AsyncWebServerRequest* request) {
+    if (!takeBody(patternBody, request)) {
+      request->send(400, "text/plain", "Pattern unvollständig oder zu groß");
+      return;
+    }
+    static HonkPattern pattern;   // fest statt auf dem async_tcp-Stack
+    if (!honkPatternFromJson(patternBody.text.c_str(), patternBody.text.length(), pattern)) {
+      request->send(400, "text/plain", "Pattern ungültig");
+      return;
+    }
+    emergencyHonkPattern = pattern;
+    saveHonkEmergencyPattern();
+    request->send(200);
+  }, nullptr, [](AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) {
+    collectBody(patternBody, request, data, len, index, total);
+  });
+
+  server.on("/morseMessage", HTTP_GET, [](AsyncWebServerRequest* request) {
+    request->send(200, "text/plain", morseMessage);
+  });
+  server.on("/morseMessage", HTTP_POST, [](AsyncWebServerRequest* request) {
+    if (!takeBody(morseBody, request)) {
+      request->send(400, "text/plain", "Nachricht unvollständig oder zu groß");
+      return;
+    }
+    morseMessage = morseBody.text;
+    morseCompiler.compile(morseMessage.c_str(), morseMessage.length(), MORSE_DIT_MS);
+    saveMorseMessage();
+    if (honkPatternActive) startHonkPattern();   // neue Nachricht sofort, von vorn
+    request->send(200);
+  }, nullptr, [](AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) {
+    collectBody(morseBody, request, data, len, index, total);
+  });
+
+  // Restliche Dateien (config, Bilder) aus LittleFS
+  server.serveStatic("/", LittleFS, "/").setCacheControl("max-age=600");
+
+  server.begin();
 }
 
-void dacTask(void* parameter) {
-  normalizeTrackLengths(tracks);
-  int64_t nextTick = esp_timer_get_time();
-  while (true) {
-    playDacSample();
+// --------------------
+// Timer-ISR-Ausgabe (AudioOutputMode::TIMER_ISR)
+// --------------------
+static SampleRing<AUDIO_RING_SIZE> sampleRing;
+
+// Von der ISR gemessen (CPU-Zyklen zwischen zwei Interrupts), vom Render-Task gelesen und zurückgesetzt
+static volatile uint32_t sampleClockLastCycles = 0;
+static volatile uint32_t sampleClockMinCycles  = UINT32_MAX;
+static volatile uint32_t sampleClockMaxCycles  = 0;
+static volatile uint32_t sampleClockNominalCycles = 0;
+static uint32_t          sampleClockCyclesPerUs   = 240;
+
+static void IRAM_ATTR onSampleTimer() {
+  uint32_t now = xthal_get_ccount();
+  uint32_t period = now - sampleClockLastCycles;
+  sampleClockLastCycles = now;
+  if (period < sampleClockMinCycles) sampleClockMinCycles = period;
+  if (period > sampleClockMaxCycles) sampleClockMaxCycles = period;
+  metricsRecordOutput(period > sampleClockNominalCycles ? (period - sampleClockNominalCycles) / sampleClockCyclesPerUs : 0);
+
+  uint8_t sample;
+  if (!sampleRing.pop(sample)) {
+    metricsRecordUnderrun();   // DAC hält den letzten Wert
+    return;
+  }
+  metricsRecordSamples(1);
+
+  // Direkt ins Register (dac_output_voltage liegt nicht im IRAM), beide Kanäle
+  SET_PERI_REG_BITS(RTC_IO_PAD_DAC1_REG, RTC_IO_PDAC1_DAC, sample, RTC_IO_PDAC1_DAC_S);
+  SET_PERI_REG_BITS(RTC_IO_PAD_DAC2_REG, RTC_IO_PDAC2_DAC, sample, RTC_IO_PDAC2_DAC_S);
+
+  // Nur beim Unterschreiten der Marke wecken, nicht bei jedem Sample
+  if (sampleRing.available() == AUDIO_RING_LOW_WATERMARK && dacTaskHandle != NULL) {
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(dacTaskHandle, &woken);
+    if (woken) portYIELD_FROM_ISR();
+  }
+}
+
+static void logSampleClockStats() {
+  uint32_t minCycles = sampleClockMinCycles;
+  uint32_t maxCycles = sampleClockMaxCycles;
+  sampleClockMinCycles = UINT32_MAX;
+  sampleClockMaxCycles = 0;
+  if (maxCycles == 0) return;
+
+  float cyclesPerUs = (float)sampleClockCyclesPerUs;
+  char msg[96];
+  snprintf(msg, sizeof(msg), "Sample-Takt: Periode %.2f..%.2f us, Jitter %.3f us, Underruns gesamt %u",
+           minCycles / cyclesPerUs, maxCycles / cyclesPerUs, (maxCycles - minCycles) / cyclesPerUs,
+           (unsigned)audioMetrics.underruns);
+  platformLog(msg);
+}
+
+// Timer-Periode auf die Rate der Engine stellen (auch im Betrieb, auto-reload übernimmt sie)
+static void setSampleTimerRate(uint32_t rate) {
+  uint32_t ticks = sampleTimerTicks(rate);
+  sampleClockNominalCycles = ticks * SAMPLE_TIMER_DIVIDER * sampleClockCyclesPerUs / 80;
+  timerAlarmWrite(timer, ticks, true);
+  metricsRecordSampleRate(rate);
+}
+
+void setupAudioOutput() {
+  if (AUDIO_OUTPUT_MODE != AudioOutputMode::I2S_DMA) {
+    dac_output_enable(DAC_CHANNEL_1);
+    dac_output_enable(DAC_CHANNEL_2);
+  }
+  if (AUDIO_OUTPUT_MODE == AudioOutputMode::TIMER_ISR) {
+    sampleClockCyclesPerUs = getCpuFrequencyMhz();
+
+    // Interrupt landet auf dem Core, der setup() ausführt (1); gestartet wird erst mit vollem Ring
+    timer = timerBegin(0, SAMPLE_TIMER_DIVIDER, true);
+    timerAttachInterrupt(timer, &onSampleTimer, true);
+    setSampleTimerRate(sampleRate);
+    return;
+  }
+  if (AUDIO_OUTPUT_MODE == AudioOutputMode::DAC_DIRECT) return;
+
+  // I2S0 → eingebauter DAC (GPIO25/26); der DMA taktet die Samples mit sampleRate aus
+  i2s_config_t config = {};
+  config.mode                 = (i2s_mode_t)(I2S_MODE_MASTER | I2S_MODE_TX | I2S_MODE_DAC_BUILT_IN);
+  config.sample_rate          = sampleRate;
+  config.bits_per_sample      = I2S_BITS_PER_SAMPLE_16BIT;
+  config.channel_format       = I2S_CHANNEL_FMT_RIGHT_LEFT;
+  config.communication_format = I2S_COMM_FORMAT_STAND_MSB;
+  config.intr_alloc_flags     = 0;
+  config.dma_buf_count        = AUDIO_DMA_BUFFER_COUNT;
+  config.dma_buf_len          = AUDIO_BLOCK_SIZE;
+  config.use_apll             = false;
+  config.tx_desc_auto_clear   = true;
+
+  // Event-Queue nur für die Telemetrie: I2S_EVENT_TX_Q_OVF = DMA-Puffer leer gelaufen
+  if (i2s_driver_install(I2S_NUM_0, &config, I2S_EVENT_QUEUE_LENGTH, &i2sEventQueue) != ESP_OK) {
+    Serial.println("Fehler: I2S-Treiber konnte nicht installiert werden!");
+    return;
+  }
+  i2s_set_pin(I2S_NUM_0, NULL);
+  i2s_set_dac_mode(I2S_DAC_CHANNEL_BOTH_EN);
+  i2s_stop(I2S_NUM_0);
+}
+
+bool dacTaskRunning() {
+  return dacTaskHandle != NULL;
+}
+
+void startDacTask() {
+  if (AUDIO_OUTPUT_MODE == AudioOutputMode::TIMER_ISR) {
+    // Render-Task auf Core 0, über async_tcp/lwIP; der Ring überbrückt WLAN-Spitzen
+    startTask(dacTask, &dacTaskHandle, DAC_TASK, DAC_TASK_STACK, configMAX_PRIORITIES - 5, 0);
+  } else {
+    startTask(dacTask, &dacTaskHandle, DAC_TASK, DAC_TASK_STACK);
+  }
+}
+
+// Beginn der laufenden Pause (platformMicros), 0 = keine. Beim Fortsetzen springt die Engine um die
+// Pausendauer weiter, damit Tracks und Gate im Takt der durchlaufenden Schleife bleiben.
+static int64_t dacPausedAtUs = 0;
+
+void pauseDacOutput() {
+  if (dacTaskHandle != NULL && dacPausedAtUs == 0) dacPausedAtUs = platformMicros();
+  if (AUDIO_OUTPUT_MODE == AudioOutputMode::TIMER_ISR && timer != nullptr) timerAlarmDisable(timer);
+  pauseTask(dacTaskHandle);
+  if (AUDIO_OUTPUT_MODE != AudioOutputMode::I2S_DMA) platformDacWrite(128);   // Mittellage halten
+  // DMA anhalten, sonst spielt auto_clear Nullen (= 0 V) statt den letzten Wert zu halten
+  if (AUDIO_OUTPUT_MODE == AudioOutputMode::I2S_DMA) i2s_stop(I2S_NUM_0);
+}
+
+void resumeDacOutput() {
+  if (dacPausedAtUs != 0) {
+    advancePlayback((uint32_t)((platformMicros() - dacPausedAtUs) / 1000));
+    dacPausedAtUs = 0;
+  }
+  if (AUDIO_OUTPUT_MODE == AudioOutputMode::I2S_DMA) i2s_start(I2S_NUM_0);
+  resumeTask(dacTaskHandle);
+  if (AUDIO_OUTPUT_MODE == AudioOutputMode::TIMER_ISR && timer != nullptr) timerAlarmEnable(timer);
+}
+
+// Der DAC-Task beendet sich selbst an der nächsten Blockgrenze: von außen gelöscht bliebe er ggf. in
+// i2s_write (Sperre des I2S-Treibers) oder mitten in applyPendingChanges() stehen. Kehrt erst zurück,
+// wenn er weg ist, damit ein folgendes startDacTask() einen neuen Task anlegt.
+void stopDacOutput() {
+  if (AUDIO_OUTPUT_MODE == AudioOutputMode::TIMER_ISR && timer != nullptr) timerAlarmDisable(timer);
+  if (AUDIO_OUTPUT_MODE == AudioOutputMode::I2S_DMA) i2s_stop(I2S_NUM_0);
+  if (dacTaskHandle != NULL) {
+    stopDacRequested = true;
+    resumeTask(dacTaskHandle);       // angehalten sähe er die Anforderung nie
+    xTaskNotifyGive(dacTaskHandle);  // DAC_DIRECT/TIMER_ISR: aus dem Warten wecken
+    while (dacTaskHandle != NULL) vTaskDelay(1);
+    stopDacRequested = false;
+  }
+  dacPausedAtUs = 0;
+  if (AUDIO_OUTPUT_MODE != AudioOutputMode::I2S_DMA) platformDacWrite(128);
+  if (AUDIO_OUTPUT_MODE == AudioOutputMode::TIMER_ISR) sampleRing.reset();
+}
+
+// Schläft bis untilUs; die letzte Tick-Periode wird aktiv gewartet, damit das nächste Sample
+// pünktlich kommt. false, wenn platformAudioChanged() vorher geweckt hat.
+static bool idleUntil(int64_t untilUs) {
+  int64_t sleepUs = untilUs - platformMicros() - portTICK_PERIOD_MS * 1000;
+  if (sleepUs > 0 && ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(sleepUs / 1000)) > 0) return false;
+
+  int64_t now = platformMicros();
+  if (now < untilUs) ets_delay_us((uint32_t)(untilUs - now));
+  return true;
+}
+
+// Boot-Messung: erster Block mit einem Sample außerhalb der Mittellage. leadUs = Vorlauf der Ausgabe
+// (DMA-Puffer, Ring), bis das Sample tatsächlich am DAC anliegt.
+static inline void noteFirstSound(const uint8_t* samples, size_t count, int64_t leadUs) {
+  if (audioMetrics.firstSoundUs != 0) return;
+  for (size_t i = 0; i < count; ++i) {
+    if (samples[i] != 128) {
+      metricsRecordFirstSound((uint32_t)(platformMicros() + leadUs));
+      return;
+    }
+  }
+}
+
+static void dacDirectLoop() {
+  int64_t  nextTick   = platformMicros();
+  uint32_t rate       = 0;
+  uint32_t intervalUs = 0;
+  uint32_t idleMin    = 0;   // Samples
+  while (!stopDacRequested) {
+    if (sampleRate != rate) {
+      rate       = sampleRate;
+      intervalUs = 1000000 / rate;
+      idleMin    = AUDIO_IDLE_MIN_MS * rate / 1000;
+      metricsRecordSampleRate(rate);
+    }
+
+    // Stille: Mittellage halten und bis zum ersten hörbaren Sample schlafen statt zu rendern
+    uint32_t silent = silentSamplesAhead();
+    if (silent >= idleMin) {
+      platformDacWrite(128);
+      uint32_t passed = silent;
+      if (!idleUntil(nextTick + (int64_t)silent * intervalUs)) {
+        // Früher geweckt (neuer Satz/Gate): nur die verstrichenen Samples überspringen
+        int64_t now = platformMicros();
+        passed = now > nextTick ? (uint32_t)((now - nextTick) / intervalUs) : 0;
+        if (passed > silent) passed = silent;
+      }
+      skipSilence(passed);
+      metricsRecordSamples(passed);
+      metricsRecordSilence(passed);
+      nextTick += (int64_t)passed * intervalUs;
+      continue;
+    }
+
+    uint8_t sample = renderSample();
+    platformDacWrite(sample);
+    metricsRecordSamples(1);
+    noteFirstSound(&sample, 1, 0);   // liegt sofort am DAC an
 
     // Nächster Zeitpunkt
-    nextTick += SAMPLE_INTERVAL_US;
+    nextTick += intervalUs;
 
     // warten bis dahin
-    int64_t now = esp_timer_get_time();
+    int64_t now = platformMicros();
     if (now < nextTick) {
+      metricsRecordOutput(0);
       // busy-wait oder vTaskDelay je nach Präzision
       ets_delay_us((uint32_t)(nextTick - now));
     } else {
       // falls wir hinterherhinken, sofort weiter
+      metricsRecordOutput((uint32_t)(now - nextTick));
       nextTick = now;
     }
   }
 }
 
-void hornTask(void* parameter) {
-  while (true) {
-    if (emergencyHonkPattern.patternChanges.empty()) {
-      vTaskDelay(100 / portTICK_PERIOD_MS); // kleine Pause, falls Pattern leer
-        continue;
+static void dacBlockLoop() {
+  // Statisch statt auf dem 4k-Task-Stack
+  static uint8_t  block[AUDIO_BLOCK_SIZE];
+  static uint16_t frames[2 * AUDIO_BLOCK_SIZE];   // rechts/links, der DAC nimmt das obere Byte
+  bool framesSilent = false;                      // frames enthält schon einen Stille-Block
+
+  uint32_t rate    = sampleRate;
+  int64_t  blockUs = (int64_t)AUDIO_BLOCK_SIZE * 1000000 / rate;
+  metricsRecordSampleRate(rate);
+
+  i2s_zero_dma_buffer(I2S_NUM_0);
+  i2s_start(I2S_NUM_0);
+
+  // Geschätzter Zeitpunkt, bis zu dem der nächste Block übergeben sein muss
+  int64_t deadline = platformMicros() + (AUDIO_DMA_BUFFER_COUNT - 1) * blockUs;
+  while (!stopDacRequested) {
+    int64_t renderStart = platformMicros();
+    size_t  count;
+    if (silentSamplesAhead() >= AUDIO_BLOCK_SIZE) {
+      // Stille: nicht rendern, Mittellage ausgeben; i2s_write blockiert danach wie sonst auch
+      skipSilence(AUDIO_BLOCK_SIZE);
+      count = AUDIO_BLOCK_SIZE;
+      if (!framesSilent) {
+        for (size_t i = 0; i < 2 * AUDIO_BLOCK_SIZE; ++i) frames[i] = 128 << 8;
+        framesSilent = true;
+      }
+      metricsRecordSilence(count);
+    } else {
+      count = renderBlock(block, AUDIO_BLOCK_SIZE);   // kürzer nur vor einem Satzwechsel
+      for (size_t i = 0; i < count; ++i) {
+        frames[2 * i] = frames[2 * i + 1] = (uint16_t)block[i] << 8;
       }
+      framesSilent = false;
+    }
+    int64_t rendered = platformMicros();
+    metricsRecordBlock((uint32_t)(rendered - renderStart));
+    metricsRecordOutput(rendered > deadline ? (uint32_t)(rendered - deadline) : 0);
+
+    // Neuer Satz mit anderer Rate: Takt sofort umstellen. Die noch im DMA liegenden Blöcke des alten
+    // Satzes laufen dabei kurz im neuen Takt – das fällt in den Satzwechsel, der ohnehin neu beginnt.
+    if (sampleRate != rate) {
+      rate    = sampleRate;
+      blockUs = (int64_t)AUDIO_BLOCK_SIZE * 1000000 / rate;
+      i2s_set_sample_rates(I2S_NUM_0, rate);
+      metricsRecordSampleRate(rate);
+      deadline = platformMicros() + (AUDIO_DMA_BUFFER_COUNT - 1) * blockUs;
+    }
+
+    // Blockiert, bis ein DMA-Puffer frei ist – der Core ist solange frei. Mit Timeout, damit eine
+    // Stopp-Anforderung auch bei angehaltenem I2S durchkommt; der Rest des Blocks entfällt dann.
+    const uint8_t* pending = (const uint8_t*)frames;
+    size_t         left    = count * 2 * sizeof(frames[0]);
+    while (left > 0 && !stopDacRequested) {
+      size_t written = 0;
+      i2s_write(I2S_NUM_0, pending, left, &written, pdMS_TO_TICKS(DAC_STOP_POLL_MS));
+      pending += written;
+      left    -= written;
+    }
+    metricsRecordSamples(count);
+    if (!framesSilent) noteFirstSound(block, count, (AUDIO_DMA_BUFFER_COUNT - 1) * blockUs);   // konservativ: volle DMA-Kette davor
+
+    // Hat i2s_write gewartet, war die DMA-Kette voll: frühestens nach den übrigen Puffern wird es
+    // knapp (konservativ). Sonst rückt die Deadline um die übergebenen Samples weiter.
+    int64_t now = platformMicros();
+    if (now - rendered > blockUs / 4) deadline = now + (AUDIO_DMA_BUFFER_COUNT - 1) * blockUs;
+    else                              deadline += (int64_t)count * 1000000 / rate;
+
+    i2s_event_t event;
+    while (xQueueReceive(i2sEventQueue, &event, 0) == pdTRUE) {
+      if (event.type == I2S_EVENT_TX_Q_OVF) metricsRecordUnderrun();
+    }
+  }
+}
 
-    TickType_t lastWakeTime = xTaskGetTickCount();
-    bool firstHigh = (emergencyHonkPattern.first == FirstSegment::FIRST_HIGH);
+static void dacTimerLoop() {
+  static uint8_t block[AUDIO_BLOCK_SIZE];
+  uint32_t rate            = sampleRate;   // Rate der Samples im Ring
+  uint32_t samplesUntilLog = SAMPLE_CLOCK_LOG_SECONDS * rate;
+
+  while (!stopDacRequested) {
+    // Ring auffüllen; die ISR weckt erst wieder an der unteren Marke
+    size_t space = sampleRing.space();
+    while (space > 0) {
+      size_t want = space < AUDIO_BLOCK_SIZE ? space : AUDIO_BLOCK_SIZE;
+      size_t count;
+      if (silentSamplesAhead() >= want) {
+        // Stille: Mittellage in den Ring statt zu rendern (der Timer-Takt läuft weiter)
+        skipSilence(want);
+        memset(block, 128, want);
+        count = want;
+        metricsRecordSilence(count);
+      } else {
+        count = renderBlock(block, want);
+      }
+
+      // Neuer Satz mit anderer Rate: erst den Ring im alten Takt ausspielen (≤ AUDIO_RING_SIZE
+      // Samples, der DAC hält solange den letzten Wert), dann den Timer umstellen
+      if (sampleRate != rate) {
+        while (timerAlarmEnabled(timer) && sampleRing.available() > 0) vTaskDelay(1);
+        rate = sampleRate;
+        setSampleTimerRate(rate);
+        samplesUntilLog = SAMPLE_CLOCK_LOG_SECONDS * rate;
+        space = sampleRing.space();
+      }
 
-    for (size_t i = 0; i < emergencyHonkPattern.patternChanges.size(); i++) {
-      // honk() oder stopHonk() je nach Index & Startstatus
-      ((i % 2 == 0) == firstHigh ? honk : stopHonk)();
+      noteFirstSound(block, count, (int64_t)sampleRing.available() * 1000000 / rate);
+      sampleRing.write(block, count);
+      space -= count;
 
-      TickType_t delayTicks = emergencyHonkPattern.patternChanges[i] / portTICK_PERIOD_MS;
-      if (delayTicks < 1) delayTicks = 1;
-        vTaskDelayUntil(&lastWakeTime, delayTicks);
+      if (count >= samplesUntilLog) {
+        logSampleClockStats();
+        samplesUntilLog = SAMPLE_CLOCK_LOG_SECONDS * rate;
+      } else {
+        samplesUntilLog -= count;
+      }
     }
+
+    if (!timerAlarmEnabled(timer)) timerAlarmEnable(timer);   // erster Start mit vollem Ring
+
+    // Timeout nur als Rückfallebene, falls eine Benachrichtigung verloren geht
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(5));
   }
 }
 
-void startTask(TaskFunction_t task, TaskHandle_t *handle, const char* taskName) {
-  if (*handle != NULL) return;
+void dacTask(void* parameter) {
+  if (AUDIO_OUTPUT_MODE == AudioOutputMode::I2S_DMA) {
+    dacBlockLoop();
+  } else if (AUDIO_OUTPUT_MODE == AudioOutputMode::TIMER_ISR) {
+    dacTimerLoop();
+  } else {
+    dacDirectLoop();
+  }
+  // Stopp angefordert: an einer Blockgrenze, ohne gehaltene Sperre; stopDacOutput() wartet hierauf.
+  // Unter dacTaskMux, damit die Diagnose den Stack nicht mehr misst, sobald der TCB freigegeben wird.
+  portENTER_CRITICAL(&dacTaskMux);
+  dacTaskHandle = NULL;
+  portEXIT_CRITICAL(&dacTaskMux);
+  vTaskDelete(NULL);
+}
 
-  xTaskCreatePinnedToCore(
-    task, taskName,
-    4096, NULL, 2, handle,
-    1
-  );
+// --------------------
+// Hupen-Pattern
+// --------------------
+// Das Muster wird einmal in eine GatePattern-Zeitleiste (ms-Grenzen) übersetzt. Der Audio-Pfad wendet
+// sie pro Sample auf den synthetisierten Horn-Ton an; der Horn-Task schaltet GPIO_HORN nach
+// derselben Zeitleiste, mit esp_timer-Weckern statt Tick-Raster.
+
+static GatePattern* compileHonkPattern(const HonkPattern& pattern) {
+  return compileGate(pattern.first == FirstSegment::FIRST_HIGH,
+                     pattern.patternChanges.data(), pattern.patternChanges.size());
 }
 
-void pauseTask(TaskHandle_t &handle) {
-  if (handle == NULL)  return;
-  vTaskSuspend(handle);
+void notifyHornTask() {
+  if (hornTaskHandle != NULL) xTaskNotify(hornTaskHandle, HORN_NOTIFY_CHANGE, eSetBits);
 }
 
-void resumeTask(TaskHandle_t &handle) {
-  if (handle == NULL) return;
-  vTaskResume(handle);
+// Eine gesetzte Morse-Nachricht hat Vorrang vor dem Hupen-Pattern
+static const HonkPattern& currentHonkPattern() {
+  const HonkPattern& morse = morseCompiler.pattern();
+  return morseMessage.length() > 0 && !morse.patternChanges.empty() ? morse : emergencyHonkPattern;
 }
 
-void killTask(TaskHandle_t &handle) {
-  if (handle == NULL) return;
-  vTaskDelete(handle);
-  handle = NULL;
+void publishHonkPattern() {
+  const HonkPattern& pattern = currentHonkPattern();
+  // Nacheinander übersetzen und veröffentlichen, damit GATE_POOL_SIZE reicht; schlägt eines fehl,
+  // läuft dort das alte Muster weiter
+  GatePattern* gate = compileHonkPattern(pattern);
+  if (gate != nullptr) publishGate(gate);
+  GatePattern* hornGate = compileHonkPattern(pattern);
+  if (hornGate != nullptr) releaseGate(pendingHornGate.exchange(hornGate));   // vom Horn-Task nie übernommen
+  if (gate == nullptr || hornGate == nullptr) Serial.println("Fehler: kein freier Gate-Slot!");
+  notifyHornTask();
 }
 
-void initTracks() {
-  for (int i = 0; i < 4; i++) {
-    TrackSegment &seg = (*activeTracks)[i][0];
-    currentSegmentIndices[i] = 0;
-    segElapsedSamples[i] = 0;
-    segSamplesLeft[i] = msToSamples(seg.duration);
-    phaseAccumulators[i] = 0.0f;
-    updatePhaseStep(i, seg.freq);
-    gainExp[i] = (seg.transition == Transition::TR_EXP) ? 0.001f : 1.0f;
-  }
+static esp_timer_handle_t hornTimer = nullptr;
+
+static void onHornTimer(void* arg) {
+  xTaskNotify(hornTaskHandle, HORN_NOTIFY_TIMER, eSetBits);
 }
 
-bool hotSwapRequired(bool dacIsPlaying) {
-  return dacIsPlaying && activeTracks == &tracks;
+// Wartet bis zum Zeitpunkt dueUs (esp_timer-Zeit); false, wenn vorher eine Änderung gemeldet wurde
+static bool waitUntilMicros(int64_t dueUs) {
+  while (true) {
+    int64_t delay = dueUs - esp_timer_get_time();
+    if (delay <= 0) return true;
+
+    esp_timer_stop(hornTimer);   // läuft er nicht, passiert nichts
+    esp_timer_start_once(hornTimer, (uint64_t)delay);
+
+    uint32_t bits = 0;
+    xTaskNotifyWait(0, UINT32_MAX, &bits, portMAX_DELAY);
+    if (bits & HORN_NOTIFY_CHANGE) {
+      esp_timer_stop(hornTimer);
+      return false;
+    }
+    // Wecker: die Schleife prüft die Zeit, ein veralteter Wecker zieht nur neu auf
+  }
 }
 
-void updateDacSettings(String jsonTracks) {
-  bool doHotSwap = hotSwapRequired(dacIsPlaying);
-  if (doHotSwap) killTask(dacTaskHandle);
-  tracks = parseTracksFromJson(jsonTracks);
-  if (doHotSwap) startTask(dacTask, &dacTaskHandle, DAC_TASK);
+void hornTask(void* parameter) {
+  esp_timer_create_args_t timerArgs = {};
+  timerArgs.callback = onHornTimer;
+  timerArgs.name     = "horn";
+  esp_timer_create(&timerArgs, &hornTimer);
+
+  GatePattern* pattern = nullptr;
+  while (true) {
+    GatePattern* next = pendingHornGate.exchange(nullptr);
+    if (next != nullptr) {
+      releaseGate(pattern);
+      pattern = next;
+    }
+
+    // Synthetisiertes Horn: der Audio-Pfad spielt das Muster, das Relais bleibt aus bis zur nächsten Änderung
+    if (!honkPatternActive || synthesizeHorn() || pattern == nullptr || pattern->endsMs.empty() || pattern->endsMs.back() == 0) {
+      stopRealHorn();
+      xTaskNotifyWait(0, UINT32_MAX, NULL, portMAX_DELAY);
+      continue;
+    }
+
+    // Zeitpunkte aus den aufsummierten Grenzen, damit nichts driftet
+    int64_t start   = esp_timer_get_time();
+    int64_t cycleMs = 0;   // Beginn des aktuellen Durchlaufs
+    size_t  run     = 0;
+    while (true) {
+      bool open = ((run % 2) == 0) == pattern->startsOpen;
+      if (open) playRealHorn();
+      else stopRealHorn();
+
+      if (!waitUntilMicros(start + (cycleMs + pattern->endsMs[run]) * 1000)) break;
+      if (++run == pattern->endsMs.size()) {
+        run = 0;
+        cycleMs += pattern->endsMs.back();
+      }
+    }
+  }
 }
 
-WaveForm waveformFromString(const char* wf) {
-  if (strcmp(wf, "sine") == 0) return WaveForm::WF_SINE;
-  if (strcmp(wf, "square") == 0) return WaveForm::WF_SQUARE;
-  if (strcmp(wf, "sawtooth") == 0) return WaveForm::WF_SAW;
-  if (strcmp(wf, "triangle") == 0) return WaveForm::WF_TRI;
-  return WaveForm::WF_SINE;
+void startTask(TaskFunction_t task, TaskHandle_t *handle, const char* taskName, uint32_t stackBytes, UBaseType_t priority, BaseType_t core) {
+  if (*handle != NULL) return;
+
+  xTaskCreatePinnedToCore(
+    task, taskName,
+    stackBytes, NULL, priority, handle,
+    core
+  );
 }
 
-Transition transitionFromString(const char* tr) {
-  if (strcmp(tr, "linear") == 0) return Transition::TR_LINEAR;
-  if (strcmp(tr, "exp") == 0) return Transition::TR_EXP;
-  // "none" oder unbekannt -> linear als Default
-  return Transition::TR_NONE;
+void pauseTask(TaskHandle_t &handle) {
+  if (handle == NULL)  return;
+  vTaskSuspend(handle);
 }
 
-std::array<std::vector<TrackSegment>, 4> parseTracksFromJson(const String& jsonTracks) {
-  std::array<std::vector<TrackSegment>, 4> tracksOut;
-  
-  // !Wichtig!: ausreichend großes JsonDocument anlegen
-  // Dein Beispiel-JSON ist ~600 Bytes groß, also nehmen wir hier 2048, um sicher zu gehen
-  JsonDocument doc;
-  
-  DeserializationError error = deserializeJson(doc, jsonTracks);
-  if (error) {
-    Serial.print(F("deserializeJson() failed: "));
-    Serial.println(error.f_str());
-    return tracksOut; // leer zurückgeben
-  }
-  
-  JsonArray tracks = doc["tracks"].as<JsonArray>();
-  uint8_t trackIdx = 0;
-  for (JsonArray trackArray : tracks) {
-    for (JsonObject seg : trackArray) {
-      TrackSegment ts;
-      ts.freq       = seg["freq"] | 0.0f;
-      ts.waveForm   = waveformFromString(seg["waveform"] | "");
-      ts.duration   = seg["duration"] | 0;
-      ts.transition = transitionFromString(seg["transition"] | "");
-      
-      tracksOut[trackIdx].push_back(ts);
-    }
-    trackIdx++;
-  }
-  
-  return tracksOut;
+void resumeTask(TaskHandle_t &handle) {
+  if (handle == NULL) return;
+  vTaskResume(handle);
 }
 
+void updateDacSettings(TrackSet* next) {
+  // Satz wurde abseits des Audio-Pfads gebaut; übernommen wird er an der nächsten Segmentgrenze
+  saveEmergencyPattern(*next);
+  compileTimeline(*next);
+  publishTracks(next);
+}
 
 String readFile(const char* path) {
   File file = LittleFS.open(path, "r");
@@ -542,9 +1295,14 @@ String readFile(const char* path) {
     return "";
   }
   
+  // Blockweise statt Zeichen für Zeichen lesen
   String content;
-  while(file.available()){
-    content += char(file.read());
+  content.reserve(file.size());
+  char buffer[257];
+  size_t len;
+  while ((len = file.read((uint8_t*)buffer, sizeof(buffer) - 1)) > 0) {
+    buffer[len] = '\0';
+    content += buffer;
   }
   file.close();
   return content;
@@ -2,96 +2,78 @@
 
 #include <Arduino.h>
 #include <driver/dac.h>
+#include <atomic>
+#include <esp_timer.h>
 #include <vector>
 
+#include "control.h"
+#include "honk_pattern.h"
+#include "synth.h"
+
 // --------------------------------------
 // GPIO-Pins (ESP32)
 // --------------------------------------
-constexpr uint8_t GPIO_HORN           = 13;
-
-constexpr uint8_t GPIO_SIGNAL_ENABLE  = 34; // HIGH: Enable
-constexpr uint8_t GPIO_SIGNAL_SELECT  = 35; // HIGH: DEFAULT; LOW: EMERGENCY
-
-constexpr uint8_t GPIO_HORN_ENABLE    = 12; // LOW: Enable → echtes Horn
-constexpr uint8_t GPIO_HONK_EMERGENCY = 14; // LOW: Enable → erzwingt Nutzung des Horns
+constexpr uint8_t GPIO_HORN           = 13;   // Eingänge: control.h
 
 // --------------------------------------
-// GPIO-Pin States
+// Eingänge (Flanken-Interrupts + Entprellung im Controller-Task)
 // --------------------------------------
-
-extern uint8_t GPIO_SIGNAL_ENABLE_LAST_STATE;
-extern uint8_t GPIO_SIGNAL_SELECT_LAST_STATE;
-
-extern uint8_t GPIO_HORN_ENABLE_LAST_STATE;
-extern uint8_t GPIO_HONK_EMERGENCY_LAST_STATE;
+// Die ISR merkt sich je Eingang die erste Flanke seit der letzten Übernahme (Zeitstempel aus
+// esp_timer, nur Differenzen werden genutzt) und weckt den Controller-Task per Notification. Der
+// entprellt (settleInputs(), control.h) und wertet aus; ohne Flanken schläft er. Ohne Queue kann
+// keine Flanke verloren gehen: viele Flanken vor dem Aufwachen fallen nur zusammen.
 
 // --------------------------------------
-// GPIO-Pin Change Times
+// Audio-Ausgabe
 // --------------------------------------
+enum class AudioOutputMode : uint8_t {
+  DAC_DIRECT,  // ein Sample pro Schleifendurchlauf, Timing per Busy-Wait
+  I2S_DMA,     // Blöcke über I2S → eingebauter DAC, Timing macht der DMA
+  TIMER_ISR    // Hardware-Timer-ISR schreibt je Sample den DAC, Render-Task (Core 0) füllt den Ring
+};
+constexpr AudioOutputMode AUDIO_OUTPUT_MODE = AudioOutputMode::I2S_DMA;
 
-extern unsigned long GPIO_SIGNAL_ENABLE_LAST_CHANGE_TIME;
-extern unsigned long GPIO_SIGNAL_SELECT_LAST_CHANGE_TIME;
+#ifndef AUDIO_BLOCK_SIZE
+#define AUDIO_BLOCK_SIZE 256      // Samples pro Block (I2S_DMA), per build_flags änderbar; max. 1024
+#endif
+constexpr uint8_t AUDIO_DMA_BUFFER_COUNT = 4;   // DMA-Puffer à AUDIO_BLOCK_SIZE Samples
 
-extern unsigned long GPIO_HORN_ENABLE_LAST_CHANGE_TIME;
-extern unsigned long GPIO_HONK_EMERGENCY_LAST_CHANGE_TIME;
+// TIMER_ISR: Timer 0 mit APB/2 = 40 MHz; 907 Ticks ≈ 44101 Hz (+32 ppm), 2500 Ticks = 16000 Hz
+constexpr uint32_t SAMPLE_TIMER_DIVIDER      = 2;
+constexpr uint32_t sampleTimerTicks(uint32_t rate) { return (80000000 / SAMPLE_TIMER_DIVIDER + rate / 2) / rate; }
+constexpr size_t   AUDIO_RING_SIZE           = 1024;                  // ≈ 23 ms bei 44,1 kHz
+constexpr size_t   AUDIO_RING_LOW_WATERMARK  = AUDIO_RING_SIZE / 2;   // ISR weckt den Render-Task
+constexpr uint32_t SAMPLE_CLOCK_LOG_SECONDS  = 10;                    // Jitter-Statistik auf Serial
 
-constexpr unsigned long DEBOUNCE_MS = 10L;
+constexpr uint32_t AUDIO_IDLE_MIN_MS         = 2;                     // DAC_DIRECT: ab hier schläft der Task in der Stille
 
-// --------------------------------------
-// Konfiguration
-// --------------------------------------
-constexpr uint32_t SAMPLE_RATE      = 44100;   // ggf. 32000 für geringere Last
-constexpr uint32_t LINEAR_FADE_MS   = 50;      // Dauer des linearen Fade-Ins
-constexpr uint32_t EXP_TAU_MS       = 100;     // Zeitkonstante für exp-Fade-In
-constexpr uint32_t SAMPLE_INTERVAL_US (1000000 / SAMPLE_RATE);
+constexpr int      I2S_EVENT_QUEUE_LENGTH    = 8;
+constexpr uint32_t DAC_STOP_POLL_MS          = 5;                     // i2s_write-Timeout: so oft sieht der DAC-Task stopDacRequested
+constexpr size_t   METRICS_TEXT_SIZE         = 4096;                  // /metrics und Serial-Dump
+constexpr size_t   JSON_ARENA_SIZE           = 6144;                  // ArduinoJson-Puffer für Pattern-Dokumente
 
 // --------------------------------------
-// Datentypen
+// Hupen-Pattern (Typen in honk_pattern.h)
 // --------------------------------------
-enum class WaveForm : uint8_t { WF_SINE=0, WF_SQUARE=1, WF_SAW=2, WF_TRI=3 };
-enum class Transition : uint8_t { TR_LINEAR=0, TR_EXP=1, TR_NONE=2 };
-
-struct TrackSegment {
-  float      freq;        // Hz
-  WaveForm   waveForm;    // siehe WaveForm
-  uint16_t   duration;    // ms
-  Transition transition;  // siehe Transition
-};
-
-enum class FirstSegment : uint8_t {FIRST_HIGH, FIRST_LOW};
-
-struct HonkPattern {
-  FirstSegment          first;          // FIRST_HIGH := Erste Laufzeit: Ton; FIRST_LOW := Erste Laufzeit: still
-  std::vector<uint32_t> patternChanges; // vector von Laufzeiten. (wechseln immer ab zwischen Ton und Stille)
-};
+static_assert(MAX_HONK_PATTERN_CHANGES <= MAX_GATE_RUNS, "Hupen-Pattern muss in ein GatePattern passen");
 
-extern HonkPattern emergencyHonkPattern;
+extern HonkPattern emergencyHonkPattern;                // gehört den Web-Handlern
+extern std::atomic<GatePattern*> pendingHornGate;       // neue Zeitleiste für den Horn-Task
+extern String morseMessage;
 
 // --------------------------------------
 // Globale Variablen (nur deklariert, in .cpp definiert)
 // --------------------------------------
-extern std::array<std::vector<TrackSegment>, 4> tracks;
-extern std::array<std::vector<TrackSegment>, 4> synthHorn;
-extern std::array<std::vector<TrackSegment>, 4>* activeTracks;
-
-extern volatile bool dacIsPlaying;
-extern volatile bool stopDacRequested;
+extern volatile bool stopDacRequested;   // stopDacOutput() → DAC-Task beendet sich selbst
 
 extern hw_timer_t* timer;
+extern QueueHandle_t i2sEventQueue;
 
-extern int       currentSegmentIndices[4];
-extern uint32_t  segSamplesLeft[4];
-extern uint32_t  segElapsedSamples[4];
-extern float     phaseAccumulators[4];
-extern float     phaseStep[4];
-extern float     gainExp[4];
-
-extern uint32_t  linearFadeSamples;
-extern float     invLinearFadeSamples;
-extern float     expAlpha;
-
-extern TaskHandle_t dacTaskHandle;
+extern TaskHandle_t dacTaskHandle;   // im Modus TIMER_ISR der Render-Task
+extern portMUX_TYPE dacTaskMux;      // der DAC-Task löscht dacTaskHandle darunter, bevor er sich beendet
 extern TaskHandle_t hornTaskHandle;
+extern TaskHandle_t controllerTaskHandle;
+extern TaskHandle_t networkTaskHandle;
 
 // --------------------------------------
 // Task-Names
@@ -99,36 +81,62 @@ extern TaskHandle_t hornTaskHandle;
 
 constexpr const char* DAC_TASK = "DAC-Task";
 constexpr const char* HORN_TASK = "Horn-Task";
+constexpr const char* CONTROLLER_TASK = "Controller-Task";
+constexpr const char* NETWORK_TASK = "Network-Task";
+
+// Stackgrößen (Bytes); Auslastung siehe /diagnostics (stackFreeMin)
+constexpr uint32_t DAC_TASK_STACK        = 4096;
+constexpr uint32_t HORN_TASK_STACK       = 4096;
+constexpr uint32_t CONTROLLER_TASK_STACK = 4096;
+constexpr uint32_t NETWORK_TASK_STACK    = 8192;   // nur beim Booten (WLAN-Init), beendet sich danach
+
+// Benachrichtigungs-Bits des Horn-Tasks
+constexpr uint32_t HORN_NOTIFY_TIMER  = 1u << 0;
+constexpr uint32_t HORN_NOTIFY_CHANGE = 1u << 1;
+
+constexpr uint32_t LOOP_IDLE_MS = 10;   // loop() bedient nur noch DNS, Aufräumen und Serial
+
+// --------------------------------------
+// Boot
+// --------------------------------------
+// setup() bringt das Signal auf Core 1 hoch, parallel startet der Network-Task auf Core 0 AP und
+// DNS. Jede Phase bekommt einen Zeitstempel (esp_timer, ab Start der App); loop() gibt sie aus,
+// damit der Boot nicht an der seriellen Schnittstelle wartet.
+constexpr uint8_t BOOT_PHASE_MAX = 12;
 
 // --------------------------------------
 // Funktions-Prototypen
 // --------------------------------------
 void doConfig();
+void setupServer();
+void networkTask(void* parameter);
 String readFile(const char* path);
 
-bool debouncedInputHasChanged(uint8_t input, unsigned long &lastChange, uint8_t &lastState);
-
-void initTracks();
-void honk();
-void emergencySignal();
-void stopHonk();
-void stopRealHorn();
-void playRealHorn();
-void controlAudioOutput();
-void updateAcousticSignal();
-
+void bootPhase(const char* name);
+void reportBoot();
+bool loadConfigJson();
+bool readBootSnapshot();
+void applyBootSnapshot();
+void saveBootSnapshot();
+
+void mountPresets();
+void loadEmergencyPattern();
+void saveEmergencyPattern(const TrackSet& set);
+void updateDacSettings(TrackSet* next);
+void loadHonkEmergencyPattern();
+void saveHonkEmergencyPattern();
+void loadMorseMessage();
+void saveMorseMessage();
+
+void setupInputs();
+void controllerTask(void* parameter);
+
+void setupAudioOutput();
 void dacTask(void* parameter);
 void hornTask(void* parameter);
-void startTask(TaskFunction_t task, TaskHandle_t *handle, const char* taskName);
+void startTask(TaskFunction_t task, TaskHandle_t *handle, const char* taskName, uint32_t stackBytes, UBaseType_t priority = 2, BaseType_t core = 1);
 void pauseTask(TaskHandle_t &handle);
 void resumeTask(TaskHandle_t &handle);
-void killTask(TaskHandle_t &handle);
-
-bool signalIsEnabled();
-bool emergencyIsSelected();
-
 
-std::array<std::vector<TrackSegment>, 4> parseTracksFromJson(const String& jsonTracks);
+void handleSerialCommands();
 
-WaveForm waveformFromString(const char* wf);
-Transition transitionFromString(const char* tr);
@@ -0,0 +1,142 @@
+#include <algorithm>
+#include <string.h>
+
+#include "morse.h"
+
+// ASCII 0x20..0x5F; Kleinbuchstaben werden vorher auf Großbuchstaben abgebildet
+static const uint8_t MORSE_ASCII[64] = {
+  0x00, 0x6B, 0x52, 0x00, 0x89, 0x00, 0x28, 0x5E,   //  !"#$%&'
+  0x36, 0x6D, 0x00, 0x2A, 0x73, 0x61, 0x55, 0x32,   // ()*+,-./
+  0x3F, 0x2F, 0x27, 0x23, 0x21, 0x20, 0x30, 0x38,   // 01234567
+  0x3C, 0x3E, 0x78, 0x6A, 0x00, 0x31, 0x00, 0x4C,   // 89:;<=>?
+  0x5A, 0x05, 0x18, 0x1A, 0x0C, 0x02, 0x12, 0x0E,   // @ABCDEFG
+  0x10, 0x04, 0x17, 0x0D, 0x14, 0x07, 0x06, 0x0F,   // HIJKLMNO
+  0x16, 0x1D, 0x0A, 0x08, 0x03, 0x09, 0x11, 0x0B,   // PQRSTUVW
+  0x19, 0x1B, 0x1C, 0x00, 0x00, 0x00, 0x00, 0x4D,   // XYZ[\]^_
+};
+
+uint8_t morseCodeFor(uint32_t codePoint) {
+  if (codePoint >= 'a' && codePoint <= 'z') codePoint -= 'a' - 'A';
+  if (codePoint >= 0x20 && codePoint < 0x60) return MORSE_ASCII[codePoint - 0x20];
+
+  switch (codePoint) {
+    case 0xC4: case 0xE4:   return 0x15;   // Ä ä  .-.-
+    case 0xD6: case 0xF6:   return 0x1E;   // Ö ö  ---.
+    case 0xDC: case 0xFC:   return 0x13;   // Ü ü  ..--
+    case 0xDF: case 0x1E9E: return 0x8C;   // ß ẞ  ...--..
+    case 0x131:             return 0x04;   // ı    toUpperCase() im Editor: I
+    case 0x17F:             return 0x08;   // ſ    S
+    default:                return 0;
+  }
+}
+
+// Ein UTF-8-Zeichen ab s[i]; liefert die Byte-Länge (ungültige Folgen zählen als 1 Byte)
+static size_t decodeUtf8(const char* s, size_t len, size_t i, uint32_t& codePoint) {
+  uint8_t c = (uint8_t)s[i];
+  size_t  n = c < 0x80 ? 1 : (c >> 5) == 0x6 ? 2 : (c >> 4) == 0xE ? 3 : (c >> 3) == 0x1E ? 4 : 0;
+  if (n == 0 || i + n > len) { codePoint = 0xFFFD; return 1; }
+
+  codePoint = n == 1 ? c : c & (0x7F >> n);
+  for (size_t k = 1; k < n; ++k) {
+    uint8_t cont = (uint8_t)s[i + k];
+    if ((cont & 0xC0) != 0x80) { codePoint = 0xFFFD; return 1; }
+    codePoint = (codePoint << 6) | (cont & 0x3F);
+  }
+  return n;
+}
+
+bool MorseCompiler::emit(bool on, uint32_t units) {
+  auto& runs = result.patternChanges;
+  uint32_t ms = units * dit;
+
+  if (runs.empty()) {
+    result.first = on ? FirstSegment::FIRST_HIGH : FirstSegment::FIRST_LOW;
+    return runs.push_back(ms);
+  }
+  bool lastOn = (((runs.size() - 1) % 2) == 0) == (result.first == FirstSegment::FIRST_HIGH);
+  if (lastOn != on) return runs.push_back(ms);
+  runs.back() += ms;
+  return true;
+}
+
+void MorseCompiler::restore(const Checkpoint& cp) {
+  result.patternChanges.resize(cp.changes);
+  if (cp.changes > 0) result.patternChanges.back() = cp.lastRun;
+}
+
+const HonkPattern& MorseCompiler::compile(const char* text, size_t len, uint32_t ditMs) {
+  // Normalisierte Eingabe = text + ggf. ' ', ohne sie dafür zu kopieren; was nicht in source passt, entfällt
+  // Gekürzt wird nur an einer Zeichengrenze, ein halbes UTF-8-Zeichen zählte sonst als unbekanntes
+  if (len > MORSE_MAX_MESSAGE_BYTES - 1) {
+    len = MORSE_MAX_MESSAGE_BYTES - 1;
+    while (len > 0 && ((uint8_t)text[len] & 0xC0) == 0x80) --len;
+  }
+  bool   appendSpace = len > 0 && text[len - 1] != ' ';
+  size_t newSize     = len + (appendSpace ? 1 : 0);
+  auto   byteAt      = [&](size_t i) { return i < len ? text[i] : ' '; };
+
+  size_t common = 0;
+  if (ditMs == dit) {
+    size_t limit = std::min(newSize, sourceLen);
+    while (common < limit && byteAt(common) == source[common]) ++common;
+    if (common == newSize && newSize == sourceLen) {
+      recompiledFrom = newSize;   // unverändert
+      return result;
+    }
+  }
+
+  memcpy(source, text, len);
+  if (appendSpace) source[len] = ' ';
+  sourceLen = newSize;
+  dit       = ditMs;
+
+  // Letztes Zeichen, das vor der ersten Abweichung beginnt – und eines davor, weil der Abstand
+  // nach einem Zeichen vom folgenden abhängt
+  size_t k = std::upper_bound(checkpoints.begin(), checkpoints.end(), common,
+                              [](size_t offset, const Checkpoint& cp) { return offset < cp.byteOffset; })
+             - checkpoints.begin();
+  k = k >= 2 ? k - 2 : 0;
+
+  size_t start = 0;
+  if (k < checkpoints.size()) {
+    start = checkpoints[k].byteOffset;
+    restore(checkpoints[k]);
+  } else {
+    result.patternChanges.clear();
+  }
+  if (result.patternChanges.empty()) result.first = FirstSegment::FIRST_HIGH;   // wie ein neuer Compiler
+  checkpoints.resize(std::min(k, checkpoints.size()));
+  recompiledFrom = start;
+  cut            = false;
+
+  size_t i = start;
+  while (i < sourceLen) {
+    const auto& runs = result.patternChanges;
+    Checkpoint cp = { (uint32_t)i, (uint32_t)runs.size(), runs.empty() ? 0u : runs.back() };
+    checkpoints.push_back(cp);   // höchstens ein Checkpoint je Byte, passt immer
+
+    uint32_t codePoint;
+    size_t next = i + decodeUtf8(source, sourceLen, i, codePoint);
+
+    bool ok = true;
+    if (codePoint == ' ') {
+      ok = emit(false, 7);
+    } else if (uint8_t code = morseCodeFor(codePoint)) {
+      int symbols = 31 - __builtin_clz(code);   // Bits unter der führenden 1
+      for (int b = symbols - 1; b >= 0 && ok; --b) {
+        ok = emit(true, ((code >> b) & 1) ? 3 : 1);
+        if (ok && b > 0) ok = emit(false, 1);
+      }
+      if (ok && next < sourceLen && source[next] != ' ') ok = emit(false, 3);
+    }
+    if (!ok) {
+      // Ergebnis voll: nur ganze Zeichen behalten, dann möglichst eine Wortpause vor der Wiederholung
+      restore(cp);
+      cut = true;
+      emit(false, 7);
+      break;
+    }
+    i = next;
+  }
+  return result;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "honk_pattern.h"
+
+// --------------------------------------
+// Morse-Compiler
+// --------------------------------------
+// Übersetzt UTF-8-Text wie generateMorseSegments() im Editor in ein HonkPattern:
+//   Dit = 1, Dah = 3, Pause im Zeichen = 1, zwischen Zeichen = 3, Leerzeichen = 7 Dits.
+// Groß-/Kleinschreibung egal, Ä/Ö/Ü/ß werden unterstützt, ı/ſ wie toUpperCase() als I/S, unbekannte
+// Zeichen übersprungen (auch Ligaturen wie ﬁ, die toUpperCase() in mehrere Buchstaben zerlegt).
+// Endet der Text nicht auf ein Leerzeichen, wird wie im Editor eines angehängt (Pause vor der
+// Wiederholung). Gleiche Zustände hintereinander werden zu einer Laufzeit zusammengefasst.
+//
+// compile() merkt sich Text, Dit-Dauer und Ergebnis. Gleiche Eingabe → keine Arbeit; geänderter
+// Text → ab dem Zeichen vor der ersten Änderung neu übersetzt (der Abstand nach einem Zeichen
+// hängt vom folgenden ab), der Anfang bleibt stehen.
+//
+// Abgleich mit dem Editor: test/golden/morse.txt (native_render, Befehl "morse").
+//
+// Alles liegt in festen Puffern: Text über MORSE_MAX_MESSAGE_BYTES wird (an einer Zeichengrenze) ignoriert, und sobald das
+// Ergebnis MAX_HONK_PATTERN_CHANGES Laufzeiten erreicht, endet es nach dem letzten ganzen Zeichen
+// (truncated()).
+
+constexpr uint32_t MORSE_DIT_MS            = 200;   // wie der Vorgabewert im Editor
+constexpr size_t   MORSE_MAX_MESSAGE_BYTES = 128;   // inkl. angehängtem Leerzeichen
+
+struct MorseCompiler {
+  const HonkPattern& compile(const char* text, size_t len, uint32_t ditMs);
+
+  const HonkPattern& pattern() const { return result; }
+  size_t lastRecompiledFrom() const { return recompiledFrom; }   // Byte-Offset, für Tests/Logs
+  bool truncated() const { return cut; }
+
+ private:
+  // Zustand vor einem Zeichen: so weit war das Ergebnis, bevor das Zeichen übersetzt wurde
+  struct Checkpoint {
+    uint32_t byteOffset;
+    uint32_t changes;     // result.patternChanges.size()
+    uint32_t lastRun;     // Wert des letzten Eintrags (wird beim Zusammenfassen verlängert)
+  };
+
+  bool emit(bool on, uint32_t units);   // false: Ergebnis voll
+  void restore(const Checkpoint& cp);
+
+  char                                          source[MORSE_MAX_MESSAGE_BYTES];   // normalisierter Text (mit angehängtem Leerzeichen)
+  size_t                                        sourceLen = 0;
+  uint32_t                                      dit = 0;
+  HonkPattern                                   result = { FirstSegment::FIRST_HIGH, {} };
+  FixedList<Checkpoint, MORSE_MAX_MESSAGE_BYTES> checkpoints;   // einer je Zeichen in source
+  size_t                                        recompiledFrom = 0;
+  bool                                          cut = false;
+};
+
+// Morse-Code eines Unicode-Zeichens: Bits unter einer führenden 1, MSB zuerst, 1 = Dah, 0 = Dit.
+// 0 = kein Morse-Zeichen.
+uint8_t morseCodeFor(uint32_t codePoint);
@@ -0,0 +1,356 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cmath>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "../../synth.h"
+#include "../../track_format.h"
+#include "../../track_parser.h"
+
+// --------------------------------------
+// Synth-Benchmark (native-Env)
+// --------------------------------------
+// pio run -e native && .pio/build/native/program [sekunden]
+//
+// Misst pro WaveForm × Transition und für die Standard-Sets (tracks, synthHorn),
+// jeweils einzeln und über renderBlock() (Block-Werte auf ein Sample umgerechnet):
+//   ns/sample     mittlere Kosten von playDacSample()
+//   samples/s     Durchsatz
+//   p99.9 ns      99.9-Perzentil einzeln getimter Samples (Timer-Overhead abgezogen)
+//   worst ns      teuerstes einzelnes Sample (enthält auf dem Host auch OS-Unterbrechungen)
+//   rate          Sample-Rate des Falls (chooseSampleRate(), wie auf dem Gerät)
+//   budget        Anteil am Zeitbudget eines Samples (1 / rate)
+//
+// Jeder Block-Fall zusätzlich im Q15-Pfad (RenderMode::FIXED, Zeile "(block q15)").
+//
+// Danach: Kosten pro Stimme (renderBlock() mit 1..TRACK_COUNT Rechteck-Stimmen), Ladezeit eines Track-Satzes als JSON (Streaming-Parser) vs. Binärformat und Kosten
+// eines Sprungs (seekTracksMs()) in Sätzen wachsender Segmentzahl.
+//
+// Vorab: maximale Abweichung des DDS-Oszillators (float und Q15) von den libm-Referenzformen.
+
+using Clock = std::chrono::steady_clock;
+
+static const char* WAVEFORM_NAMES[]   = { "sine", "square", "sawtooth", "triangle" };
+static const char* TRANSITION_NAMES[] = { "linear", "exp", "none" };
+
+// Blockgröße für die renderBlock()-Messung (entspricht AUDIO_BLOCK_SIZE auf dem Gerät)
+constexpr size_t BENCH_BLOCK_SIZE = 256;
+
+// Kurze Segmente, damit die Fades im Messfenster regelmäßig neu starten
+constexpr uint16_t BENCH_SEGMENT_MS = 200;
+
+struct BenchResult {
+  double nsPerSample;
+  double samplesPerSec;
+  double p999Ns;
+  double worstNs;
+};
+
+static double timerOverheadNs() {
+  // Kleinstes Intervall zweier direkt aufeinanderfolgender Zeitstempel
+  double best = 1e9;
+  for (int i = 0; i < 10000; ++i) {
+    auto a = Clock::now();
+    auto b = Clock::now();
+    best = std::min(best, (double)std::chrono::duration_cast<std::chrono::nanoseconds>(b - a).count());
+  }
+  return best;
+}
+
+static BenchResult runBench(TrackSet& set, uint32_t samples, double overheadNs, RenderMode mode = RenderMode::FLOAT) {
+  BenchResult result{};
+  activeTracks = &set;
+  setSampleRate(chooseSampleRate(set));
+  setRenderMode(mode);
+
+  // Aufwärmen (Caches, Branch-Predictor)
+  initTracks();
+  for (uint32_t i = 0; i < sampleRate / 10; ++i) playDacSample();
+
+  // Durchsatz am Stück
+  initTracks();
+  auto start = Clock::now();
+  for (uint32_t i = 0; i < samples; ++i) playDacSample();
+  double totalNs = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+
+  result.nsPerSample   = totalNs / samples;
+  result.samplesPerSec = 1e9 / result.nsPerSample;
+
+  // Worst Case: jedes Sample einzeln timen
+  initTracks();
+  std::vector<double> perSample(samples);
+  for (uint32_t i = 0; i < samples; ++i) {
+    auto a = Clock::now();
+    playDacSample();
+    auto b = Clock::now();
+    perSample[i] = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(b - a).count() - overheadNs;
+  }
+  std::sort(perSample.begin(), perSample.end());
+  result.p999Ns  = std::max(0.0, perSample[(size_t)(samples * 0.999)]);
+  result.worstNs = std::max(0.0, perSample.back());
+
+  return result;
+}
+
+static BenchResult runBlockBench(TrackSet& set, uint32_t samples, double overheadNs, RenderMode mode = RenderMode::FLOAT) {
+  BenchResult result{};
+  activeTracks = &set;
+  setSampleRate(chooseSampleRate(set));
+  setRenderMode(mode);
+  uint8_t block[BENCH_BLOCK_SIZE];
+  const uint32_t blocks = samples / BENCH_BLOCK_SIZE;
+
+  initTracks();
+  renderBlock(block, BENCH_BLOCK_SIZE);
+
+  // Pro Block timen; worst wird auf ein Sample umgerechnet
+  initTracks();
+  std::vector<double> perSample(blocks);
+  double totalNs = 0.0;
+  for (uint32_t b = 0; b < blocks; ++b) {
+    auto a = Clock::now();
+    renderBlock(block, BENCH_BLOCK_SIZE);
+    auto e = Clock::now();
+    double ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(e - a).count() - overheadNs;
+    totalNs += ns;
+    perSample[b] = ns / BENCH_BLOCK_SIZE;
+  }
+  std::sort(perSample.begin(), perSample.end());
+
+  result.nsPerSample   = totalNs / ((double)blocks * BENCH_BLOCK_SIZE);
+  result.samplesPerSec = 1e9 / result.nsPerSample;
+  result.p999Ns        = std::max(0.0, perSample[(size_t)(blocks * 0.999)]);
+  result.worstNs       = std::max(0.0, perSample.back());
+  return result;
+}
+
+static float referenceWave(WaveForm waveForm, double phase) {
+  // Ursprüngliche Float-Formeln auf Phase 0..2pi
+  switch (waveForm) {
+    case WaveForm::WF_SINE:   return (float)std::sin(phase);
+    case WaveForm::WF_SQUARE: return std::sin(phase) >= 0.0 ? 1.0f : -1.0f;
+    case WaveForm::WF_SAW:    return (float)(phase / M_PI - 1.0);
+    case WaveForm::WF_TRI: {
+      double t = phase / (2.0 * M_PI);
+      return (float)-(2.0 * std::fabs(2.0 * (t - std::floor(t + 0.5))) - 1.0);
+    }
+  }
+  return 0.0f;
+}
+
+static void printOscillatorAccuracy() {
+  std::printf("%-26s %12s %12s %12s\n", "oscillator", "max |err|", "mismatches", "q15 |err|");
+  for (int wf = 0; wf < 4; ++wf) {
+    double   maxErr     = 0.0;
+    double   maxErrQ15  = 0.0;
+    uint32_t mismatches = 0;   // Rechteck: Vorzeichen weicht ab (nur direkt an 0/pi)
+    for (uint64_t p = 0; p < (1ull << 32); p += 4099) {
+      float dds = generateWave((WaveForm)wf, (uint32_t)p);
+      float ref = referenceWave((WaveForm)wf, (double)p * (2.0 * M_PI / 4294967296.0));
+      double err = std::fabs((double)dds - ref);
+      if ((WaveForm)wf == WaveForm::WF_SQUARE) {
+        if (err > 0.0) mismatches++;
+      } else {
+        maxErr    = std::max(maxErr, err);
+        maxErrQ15 = std::max(maxErrQ15, std::fabs((double)generateWaveQ15((WaveForm)wf, (uint32_t)p) / Q15_ONE - ref));
+      }
+    }
+    std::printf("%-26s %12.2e %12u %12.2e\n", WAVEFORM_NAMES[wf], maxErr, mismatches, maxErrQ15);
+  }
+  std::printf("\n");
+}
+
+static void printResult(const char* name, const BenchResult& r) {
+  // Rate des zuletzt gemessenen Satzes
+  const double budgetNs = 1e9 / sampleRate;
+  std::printf("%-26s %10.1f %14.0f %10.1f %10.1f %6u %8.2f%%\n",
+              name, r.nsPerSample, r.samplesPerSec, r.p999Ns, r.worstNs, sampleRate, 100.0 * r.nsPerSample / budgetNs);
+}
+
+static std::string tracksToJson(const TrackSet& set) {
+  std::string json = "{\"tracks\":[";
+  for (size_t t = 0; t < set.size(); ++t) {
+    json += t ? ",[" : "[";
+    for (size_t i = 0; i < set[t].size(); ++i) {
+      const TrackSegment& seg = set[t][i];
+      char buf[128];
+      std::snprintf(buf, sizeof(buf), "%s{\"freq\":%g,\"waveform\":\"%s\",\"duration\":%u,\"transition\":\"%s\"}",
+                    i ? "," : "", seg.freq, seg.waveForm == WaveForm::WF_SAW ? "sawtooth" : WAVEFORM_NAMES[(int)seg.waveForm],
+                    seg.duration, TRANSITION_NAMES[(int)seg.transition]);
+      json += buf;
+    }
+    json += "]";
+  }
+  return json + "]}";
+}
+
+static void printLoadTimes(const TrackSet& set, const char* name) {
+  const int rounds = 2000;
+  std::string json = tracksToJson(set);
+  uint8_t binary[TRACKS_BINARY_MAX_SIZE];
+  size_t binaryLen = encodeTracksBinary(set, binary, sizeof(binary));
+
+  TrackSet out;
+  auto a = Clock::now();
+  for (int i = 0; i < rounds; ++i) {
+    TrackJsonParser parser;
+    parser.begin(out);
+    parser.feed(json.data(), json.size());
+    parser.finish();
+  }
+  auto b = Clock::now();
+  for (int i = 0; i < rounds; ++i) decodeTracksBinary(binary, binaryLen, out);
+  auto c = Clock::now();
+
+  std::printf("%-26s %6zu B JSON %8.2f us   %6zu B binär %8.2f us\n", name,
+              json.size(), std::chrono::duration<double, std::micro>(b - a).count() / rounds,
+              binaryLen, std::chrono::duration<double, std::micro>(c - b).count() / rounds);
+}
+
+static void printVoiceScaling(uint32_t samples, double overheadNs) {
+  for (size_t voices = 1; voices <= TRACK_COUNT; voices *= 2) {
+    TrackSet set;
+    for (size_t t = 0; t < voices; ++t) {
+      set[t] = { TrackSegment{ 300.0f + 7.0f * t, BENCH_SEGMENT_MS, WaveForm::WF_SQUARE, Transition::TR_NONE } };
+    }
+    compileTimeline(set);
+
+    char name[40];
+    std::snprintf(name, sizeof(name), "%zu voices (block)", voices);
+    printResult(name, runBlockBench(set, samples, overheadNs));
+  }
+}
+
+static void printSeekTimes(size_t segments) {
+  const int rounds = 20000;
+  TrackSet set;
+  for (size_t t = 0; t < set.size(); ++t) {
+    for (size_t i = 0; i < segments; ++i) {
+      set[t].push_back(TrackSegment{ 300.0f + (float)(i % 50), (uint16_t)(20 + (i + t) % 7), WaveForm::WF_SQUARE, Transition::TR_NONE });
+    }
+  }
+  compileTimeline(set);
+  activeTracks = &set;
+  setSampleRate(chooseSampleRate(set));
+
+  uint32_t loopMs = set[0].back().endMs;
+  auto a = Clock::now();
+  for (int i = 0; i < rounds; ++i) seekTracksMs((uint32_t)(((uint64_t)i * 7919) % loopMs));
+  auto b = Clock::now();
+
+  char name[40];
+  std::snprintf(name, sizeof(name), "seek %zu segments", segments);
+  std::printf("%-26s %8.3f us\n", name, std::chrono::duration<double, std::micro>(b - a).count() / rounds);
+}
+
+// Eine Frequenzänderung im Editor: ganzer Satz als JSON (parsen, Timeline, Spiegel für tracks.bin)
+// gegen Live-Patch (Nachricht prüfen, Spiegel + CRC, Timeline)
+static void printEditTimes(size_t segments) {
+  const int rounds = 2000;
+  TrackSet set;
+  for (size_t t = 0; t < set.size(); ++t) {
+    for (size_t i = 0; i < segments; ++i) {
+      set[t].push_back(TrackSegment{ 300.0f + (float)(i % 50), (uint16_t)(20 + (i + t) % 7), WaveForm::WF_SQUARE, Transition::TR_NONE });
+    }
+  }
+  std::string json = tracksToJson(set);
+  uint8_t binary[TRACKS_BINARY_MAX_SIZE];
+  size_t binaryLen = encodeTracksBinary(set, binary, sizeof(binary));
+
+  SegmentPatch patch = {};
+  patch.track        = 0;
+  patch.segment      = (uint16_t)(segments / 2);
+  patch.fields       = PATCH_FREQ;
+  patch.values.freq  = 440.0f;
+  uint8_t message[PATCH_MESSAGE_MAX_SIZE];
+  size_t messageLen = encodePatchMessage(patch, 1, message, sizeof(message));
+
+  TrackSet out;
+  auto a = Clock::now();
+  for (int i = 0; i < rounds; ++i) {
+    TrackJsonParser parser;
+    parser.begin(out);
+    parser.feed(json.data(), json.size());
+    parser.finish();
+    compileTimeline(out);
+    encodeTracksBinary(out, binary, sizeof(binary));
+  }
+  auto b = Clock::now();
+  for (int i = 0; i < rounds; ++i) {
+    SegmentPatch decoded;
+    uint32_t version;
+    decodePatchMessage(message, messageLen, decoded, version);
+    patchTracksBinary(binary, binaryLen, decoded);
+    out[decoded.track][decoded.segment].freq = decoded.values.freq;
+    compileTimeline(out);
+  }
+  auto c = Clock::now();
+
+  char name[40];
+  std::snprintf(name, sizeof(name), "edit %zu segments", segments);
+  std::printf("%-26s %6zu B JSON %8.2f us   %6zu B Patch %8.2f us\n", name,
+              json.size(), std::chrono::duration<double, std::micro>(b - a).count() / rounds,
+              messageLen, std::chrono::duration<double, std::micro>(c - b).count() / rounds);
+}
+
+int main(int argc, char** argv) {
+  double seconds = argc > 1 ? std::atof(argv[1]) : 2.0;
+  if (seconds <= 0.0) seconds = 2.0;
+  const uint32_t samples = (uint32_t)(seconds * SAMPLE_RATE);
+
+  initSynth();
+  const double overheadNs = timerOverheadNs();
+
+  printOscillatorAccuracy();
+
+  std::printf("Rate je Fall aus chooseSampleRate() (max. SAMPLE_RATE %u Hz), %u Samples pro Lauf\n\n",
+              SAMPLE_RATE, samples);
+  std::printf("%-26s %10s %14s %10s %10s %6s %9s\n", "case", "ns/sample", "samples/s", "p99.9 ns", "worst ns", "rate", "budget");
+
+  for (int wf = 0; wf < 4; ++wf) {
+    for (int tr = 0; tr < 3; ++tr) {
+      // Vier leicht verstimmte Stimmen, wie im Standard-Set
+      TrackSet set;
+      for (int t = 0; t < 4; ++t) {
+        set[t] = { TrackSegment{ 440.0f + 0.5f * t, BENCH_SEGMENT_MS, (WaveForm)wf, (Transition)tr } };
+      }
+      compileTimeline(set);
+
+      char name[40];
+      std::snprintf(name, sizeof(name), "%s/%s", WAVEFORM_NAMES[wf], TRANSITION_NAMES[tr]);
+      printResult(name, runBench(set, samples, overheadNs));
+      std::snprintf(name, sizeof(name), "%s/%s (block)", WAVEFORM_NAMES[wf], TRANSITION_NAMES[tr]);
+      printResult(name, runBlockBench(set, samples, overheadNs));
+      std::snprintf(name, sizeof(name), "%s/%s (block q15)", WAVEFORM_NAMES[wf], TRANSITION_NAMES[tr]);
+      printResult(name, runBlockBench(set, samples, overheadNs, RenderMode::FIXED));
+    }
+  }
+
+  std::printf("\n");
+  printResult("tracks", runBench(tracks, samples, overheadNs));
+  printResult("synthHorn", runBench(synthHorn, samples, overheadNs));
+  printResult("tracks (block)", runBlockBench(tracks, samples, overheadNs));
+  printResult("synthHorn (block)", runBlockBench(synthHorn, samples, overheadNs));
+  printResult("tracks (block q15)", runBlockBench(tracks, samples, overheadNs, RenderMode::FIXED));
+  printResult("synthHorn (block q15)", runBlockBench(synthHorn, samples, overheadNs, RenderMode::FIXED));
+
+  std::printf("\n");
+  printVoiceScaling(samples, overheadNs);
+
+  std::printf("\n");
+  printLoadTimes(tracks, "load tracks");
+  printLoadTimes(synthHorn, "load synthHorn");
+
+  std::printf("\n");
+  printSeekTimes(8);
+  printSeekTimes(MAX_SEGMENTS_PER_TRACK);
+
+  std::printf("\n");
+  printEditTimes(8);
+  printEditTimes(MAX_SEGMENTS_PER_TRACK);
+
+  return 0;
+}
@@ -0,0 +1,43 @@
+#include <chrono>
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../platform.h"
+
+// Letzter geschriebener DAC-Wert; verhindert, dass der Compiler die Ausgabe wegoptimiert
+volatile uint8_t nativeDacValue = 128;
+
+void platformDacWrite(uint8_t value) {
+  nativeDacValue = value;
+}
+
+int64_t platformMicros() {
+  using namespace std::chrono;
+  return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+void platformLog(const char* message) {
+  std::fprintf(stderr, "%s\n", message);
+}
+
+void platformAudioChanged() {
+  // Host rendert synchron, es schläft nichts
+}
+
+const uint8_t* platformMapReadOnly(const char* name, size_t& size) {
+  size = 0;
+  int fd = open(name, O_RDONLY);
+  if (fd < 0) return nullptr;
+
+  struct stat st;
+  void* mapped = MAP_FAILED;
+  if (fstat(fd, &st) == 0 && st.st_size > 0) mapped = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);   // das Mapping bleibt bestehen
+  if (mapped == MAP_FAILED) return nullptr;
+
+  size = (size_t)st.st_size;
+  return (const uint8_t*)mapped;
+}
@@ -0,0 +1,591 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../../morse.h"
+#include "../../platform.h"
+#include "../../preset_bank.h"
+#include "../../synth.h"
+#include "../../track_format.h"
+#include "../../track_parser.h"
+
+// --------------------------------------
+// Offline-Renderer + Golden-Checks (native_render-Env)
+// --------------------------------------
+// pio run -e native_render && .pio/build/native_render/program <befehl> ...
+//
+//   render <satz> <sekunden> <out.wav> [--gate open|closed:ms,ms,...] [--rate hz] [--start ms] [--block]
+//          [--fixed] [--dither]
+//       Rendert mit der Geräte-Engine (renderSample() wie playDacSample(), bzw. renderBlock())
+//       in eine 8-Bit-Mono-WAV und meldet das Vielfache der Echtzeit. Die Rate wählt wie auf dem
+//       Gerät chooseSampleRate(), --rate erzwingt eine feste. --start beginnt an Position ms der
+//       Schleife (seekTracksMs()). --fixed rechnet im Q15-Pfad (RenderMode::FIXED), --dither
+//       zusätzlich mit TPDF-Dither.
+//   check <golden.txt> [--update]
+//       Rendert jeden Fall über renderSample(), renderBlock() und renderBlock() mit übersprungener
+//       Stille (skipSilence(), wie die Ausgabe auf dem Gerät) und vergleicht die CRC32 mit dem
+//       eingetragenen Wert.
+//       Exit-Code 1 bei Abweichung; --update schreibt die aktuellen Werte zurück.
+//   compare <a.wav> <b.wav> [--tolerance n]
+//       Für Optimierungen mit erlaubtem Fehler: max. |Differenz| in LSB, RMS, Anzahl
+//       abweichender Samples. Exit-Code 1, wenn die max. Differenz über der Toleranz liegt.
+//   bank <out.bin> <name>=<satz> ...
+//       Schreibt eine Preset-Bank (preset_bank.h) aus den Sätzen, in der angegebenen Reihenfolge.
+//   morse <golden.txt>
+//       Übersetzt jeden Text mit dem MorseCompiler (neu und inkrementell nach dem vorigen Fall) und
+//       vergleicht mit den Laufzeiten des Editors (generateMorseSegments(), eingetragen von
+//       test/golden/morse_reference.js). Exit-Code 1 bei Abweichung.
+//   allocs [zyklen]
+//       Zählt operator new über Zyklen aus Upload (Streaming-Parser), Binärformat, Timeline,
+//       publishTracks(), Live-Patch, Gate, Morse-Compiler und Rendern – der Weg eines
+//       Pattern-Wechsels auf dem Gerät. Exit-Code 1 bei mindestens einer Allokation.
+//
+// <satz> ist "tracks", "synthHorn", eine Track-JSON-Datei im Format von parseTracksFromJson() oder
+// <bank.bin>#<name|index> für ein Preset. Wie auf dem Gerät wird ein JSON-Satz mit compileTimeline()
+// vorbereitet; ein Preset wird per mmap eingebunden und ohne Kopie direkt aus dem Mapping gespielt.
+
+using Clock = std::chrono::steady_clock;
+
+// Blockgröße des renderBlock()-Pfads (entspricht AUDIO_BLOCK_SIZE auf dem Gerät)
+constexpr size_t RENDER_BLOCK_SIZE = 256;
+
+enum class RenderPath { SAMPLE, BLOCK, SKIP_SILENCE };
+
+// Zähler für "allocs": zählt nur, solange countAllocations gesetzt ist
+static bool countAllocations = false;
+static long allocationCount  = 0;
+
+void* operator new(size_t size) {
+  if (countAllocations) allocationCount++;
+  void* p = std::malloc(size ? size : 1);
+  if (p == nullptr) throw std::bad_alloc();
+  return p;
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+// Rechenweg eines Renders (Spalte "modus" der Golden-Datei: float, fixed, fixed+dither)
+struct RenderFormat {
+  RenderMode mode;
+  bool       dither;
+};
+
+struct RenderCase {
+  std::string  name;
+  std::string  set;
+  double       seconds;
+  uint32_t     rate;    // 0 = wie auf dem Gerät
+  RenderFormat format;
+  std::string  gate;    // "-" = kein Gate
+  uint32_t     crc;
+};
+
+static bool parseFormat(const std::string& spec, RenderFormat& format) {
+  if (spec == "float")        { format = { RenderMode::FLOAT, false }; return true; }
+  if (spec == "fixed")        { format = { RenderMode::FIXED, false }; return true; }
+  if (spec == "fixed+dither") { format = { RenderMode::FIXED, true };  return true; }
+  std::fprintf(stderr, "Modus ungültig: %s\n", spec.c_str());
+  return false;
+}
+
+static const char* formatName(const RenderFormat& format) {
+  if (format.mode == RenderMode::FLOAT) return "float";
+  return format.dither ? "fixed+dither" : "fixed";
+}
+
+// Preset aus einer Bank-Datei; die Bank bleibt bis zum Programmende gemappt und eingebunden
+static const TrackSet* loadPreset(const std::string& spec) {
+  size_t hash = spec.rfind('#');
+  std::string path = spec.substr(0, hash);
+  std::string key  = spec.substr(hash + 1);
+
+  static std::string mountedPath;
+  if (path != mountedPath) {
+    size_t size;
+    const uint8_t* image = platformMapReadOnly(path.c_str(), size);
+    if (image == nullptr || !mountPresetBank(image, size)) {
+      std::fprintf(stderr, "%s: keine gültige Preset-Bank\n", path.c_str());
+      return nullptr;
+    }
+    mountedPath = path;
+  }
+
+  int index = findPreset(key.c_str());
+  if (index < 0 && !key.empty() && key.find_first_not_of("0123456789") == std::string::npos) index = std::atoi(key.c_str());
+  const TrackSet* preset = index >= 0 ? presetTracks((size_t)index) : nullptr;
+  if (preset == nullptr) std::fprintf(stderr, "%s: Preset %s unbekannt\n", path.c_str(), key.c_str());
+  return preset;
+}
+
+// Liefert den zu spielenden Satz: storage für eingebaute und JSON-Sätze, sonst das Preset im Mapping
+static const TrackSet* loadSet(const std::string& name, TrackSet& storage) {
+  if (name.find('#') != std::string::npos) return loadPreset(name);
+  TrackSet& out = storage;
+  if (name == "tracks")    { out = tracks;    compileTimeline(out); return &out; }
+  if (name == "synthHorn") { out = synthHorn; return &out; }
+
+  std::ifstream file(name, std::ios::binary);
+  if (!file) {
+    std::fprintf(stderr, "%s: nicht lesbar\n", name.c_str());
+    return nullptr;
+  }
+  std::stringstream json;
+  json << file.rdbuf();
+  out = parseTracksFromJson(json.str().c_str());
+
+  bool empty = true;
+  for (const auto& track : out) empty = empty && track.empty();
+  if (empty) {
+    std::fprintf(stderr, "%s: keine Tracks\n", name.c_str());
+    return nullptr;
+  }
+  compileTimeline(out);
+  return &out;
+}
+
+// "open:25,400,..." bzw. "closed:..." → Gate; "-" → kein Gate (nullptr)
+static bool parseGate(const std::string& spec, GatePattern*& gate) {
+  gate = nullptr;
+  if (spec == "-") return true;
+
+  size_t colon = spec.find(':');
+  std::string start = spec.substr(0, colon);
+  if (colon == std::string::npos || (start != "open" && start != "closed")) {
+    std::fprintf(stderr, "Gate ungültig: %s\n", spec.c_str());
+    return false;
+  }
+  std::vector<uint32_t> durations;
+  std::stringstream list(spec.substr(colon + 1));
+  std::string item;
+  while (std::getline(list, item, ',')) durations.push_back((uint32_t)std::strtoul(item.c_str(), nullptr, 10));
+
+  gate = compileGate(start == "open", durations.data(), durations.size());
+  if (gate == nullptr) {
+    std::fprintf(stderr, "%s: kein freier Gate-Slot\n", spec.c_str());
+    return false;
+  }
+  return true;
+}
+
+// Spielt einen Satz ab startMs mit dem angegebenen Gate. Vorher wird das Gate geöffnet und die
+// Rampe ausgespielt, damit jeder Lauf unabhängig vom vorherigen im selben Zustand beginnt.
+static void startRender(const TrackSet& set, GatePattern* gate, uint32_t rate, RenderFormat format, uint32_t startMs) {
+  uint8_t settle[RENDER_CHUNK];
+  activeTracks = &set;
+  setSampleRate(rate != 0 ? rate : chooseSampleRate(set));
+  setRenderMode(format.mode, format.dither);
+  publishGate(nullptr);
+  for (uint32_t n = 0; n <= sampleRate * GATE_RAMP_MS / 1000; n += RENDER_CHUNK) renderBlock(settle, RENDER_CHUNK);
+
+  publishGate(gate);
+  seekTracksMs(startMs);
+}
+
+// Rendert seconds Sekunden in out; liefert die Renderzeit in Sekunden
+static double render(const TrackSet& set, GatePattern* gate, uint32_t rate, RenderFormat format, uint32_t startMs,
+                     RenderPath path, double seconds, std::vector<uint8_t>& out) {
+  startRender(set, gate, rate, format, startMs);
+  out.resize((size_t)(seconds * sampleRate));
+
+  auto start = Clock::now();
+  size_t i = 0;
+  while (i < out.size()) {
+    size_t want = std::min(RENDER_BLOCK_SIZE, out.size() - i);
+    switch (path) {
+      case RenderPath::SAMPLE:
+        out[i++] = renderSample();
+        break;
+      case RenderPath::BLOCK:
+        i += renderBlock(out.data() + i, want);
+        break;
+      case RenderPath::SKIP_SILENCE: {
+        size_t silent = std::min<size_t>(silentSamplesAhead(), out.size() - i);
+        if (silent > 0) {
+          skipSilence((uint32_t)silent);
+          std::memset(out.data() + i, 128, silent);
+          i += silent;
+        } else {
+          i += renderBlock(out.data() + i, want);
+        }
+        break;
+      }
+    }
+  }
+  double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+  publishGate(nullptr);
+  reclaimRetiredGate();
+  return elapsed;
+}
+
+static double realtimeMultiple(size_t samples, double elapsed) {
+  return elapsed > 0.0 ? (double)samples / sampleRate / elapsed : INFINITY;
+}
+
+// --------------------------------------
+// WAV (PCM, 8 Bit unsigned, mono)
+// --------------------------------------
+
+static void putLe(std::string& out, uint32_t value, int bytes) {
+  for (int i = 0; i < bytes; ++i) out += (char)((value >> (8 * i)) & 0xFF);
+}
+
+static bool writeWav(const char* path, const std::vector<uint8_t>& samples, uint32_t rate) {
+  std::string header = "RIFF";
+  putLe(header, 36 + (uint32_t)samples.size(), 4);
+  header += "WAVEfmt ";
+  putLe(header, 16, 4);            // fmt-Chunk-Größe
+  putLe(header, 1, 2);             // PCM
+  putLe(header, 1, 2);             // mono
+  putLe(header, rate, 4);
+  putLe(header, rate, 4);          // Bytes/s
+  putLe(header, 1, 2);             // Block-Align
+  putLe(header, 8, 2);             // Bits/Sample
+  header += "data";
+  putLe(header, (uint32_t)samples.size(), 4);
+
+  std::ofstream file(path, std::ios::binary);
+  file.write(header.data(), header.size());
+  file.write((const char*)samples.data(), samples.size());
+  return (bool)file;
+}
+
+static bool readWav(const char* path, std::vector<uint8_t>& samples, uint32_t& rate) {
+  std::ifstream file(path, std::ios::binary);
+  std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+  // Nur das eigene Format: 8 Bit mono, "data" direkt nach dem fmt-Chunk
+  if (data.size() < 44 || data.compare(0, 4, "RIFF") != 0 || data.compare(36, 4, "data") != 0
+      || (uint8_t)data[34] != 8 || (uint8_t)data[22] != 1) {
+    std::fprintf(stderr, "%s: keine 8-Bit-Mono-WAV\n", path);
+    return false;
+  }
+  rate = (uint8_t)data[24] | (uint8_t)data[25] << 8 | (uint8_t)data[26] << 16 | (uint32_t)(uint8_t)data[27] << 24;
+  samples.assign(data.begin() + 44, data.end());
+  return true;
+}
+
+// --------------------------------------
+// Befehle
+// --------------------------------------
+
+static int cmdRender(int argc, char** argv) {
+  if (argc < 5) return 2;
+  std::string gateSpec = "-";
+  uint32_t rate = 0;
+  uint32_t startMs = 0;
+  bool block = false;
+  RenderFormat format = { RenderMode::FLOAT, false };
+  for (int i = 5; i < argc; ++i) {
+    if (std::strcmp(argv[i], "--block") == 0) block = true;
+    else if (std::strcmp(argv[i], "--fixed") == 0) format.mode = RenderMode::FIXED;
+    else if (std::strcmp(argv[i], "--dither") == 0) format.dither = true;
+    else if (std::strcmp(argv[i], "--gate") == 0 && i + 1 < argc) gateSpec = argv[++i];
+    else if (std::strcmp(argv[i], "--rate") == 0 && i + 1 < argc) rate = (uint32_t)std::atoi(argv[++i]);
+    else if (std::strcmp(argv[i], "--start") == 0 && i + 1 < argc) startMs = (uint32_t)std::atoi(argv[++i]);
+    else return 2;
+  }
+
+  TrackSet storage;
+  GatePattern* gate;
+  const TrackSet* set = loadSet(argv[2], storage);
+  if (set == nullptr || !parseGate(gateSpec, gate)) return 1;
+
+  std::vector<uint8_t> samples;
+  double elapsed = render(*set, gate, rate, format, startMs, block ? RenderPath::BLOCK : RenderPath::SAMPLE,
+                          std::atof(argv[3]), samples);
+  if (!writeWav(argv[4], samples, sampleRate)) {
+    std::fprintf(stderr, "%s: Schreiben fehlgeschlagen\n", argv[4]);
+    return 1;
+  }
+
+  std::printf("%s: %zu Samples @ %u Hz, crc32 %08x, %.1fx Echtzeit (%s, %s)\n", argv[4], samples.size(),
+              sampleRate, crc32(samples.data(), samples.size()), realtimeMultiple(samples.size(), elapsed),
+              block ? "renderBlock" : "renderSample", formatName(format));
+  return 0;
+}
+
+static bool parseCaseLine(const std::string& line, RenderCase& c) {
+  std::stringstream fields(line);
+  std::string rate, format, crc;
+  if (!(fields >> c.name >> c.set >> c.seconds >> rate >> format >> c.gate >> crc)) return false;
+  if (!parseFormat(format, c.format)) return false;
+  c.rate = rate == "auto" ? 0 : (uint32_t)std::strtoul(rate.c_str(), nullptr, 10);
+  c.crc  = (uint32_t)std::strtoul(crc.c_str(), nullptr, 16);
+  return true;
+}
+
+static int cmdCheck(int argc, char** argv) {
+  if (argc < 3) return 2;
+  const char* goldenPath = argv[2];
+  bool update = argc > 3 && std::strcmp(argv[3], "--update") == 0;
+
+  std::ifstream file(goldenPath);
+  if (!file) {
+    std::fprintf(stderr, "%s: nicht lesbar\n", goldenPath);
+    return 1;
+  }
+  // Satz-Dateien relativ zur Golden-Datei
+  std::string dir = goldenPath;
+  dir = dir.find('/') == std::string::npos ? "" : dir.substr(0, dir.rfind('/') + 1);
+
+  std::vector<std::string> lines;
+  std::string line;
+  int failures = 0;
+  std::printf("%-20s %8s %10s %10s %12s %12s %12s  %s\n", "case", "rate", "expected", "actual",
+              "xRT sample", "xRT block", "xRT skip", "");
+
+  while (std::getline(file, line)) {
+    RenderCase c;
+    if (line.empty() || line[0] == '#' || !parseCaseLine(line, c)) {
+      lines.push_back(line);
+      continue;
+    }
+
+    TrackSet storage;
+    GatePattern* gate;
+    std::string setPath = (c.set == "tracks" || c.set == "synthHorn") ? c.set : dir + c.set;
+    const TrackSet* set = loadSet(setPath, storage);
+    if (set == nullptr || !parseGate(c.gate, gate)) return 1;
+
+    std::vector<uint8_t> bySample, byBlock, bySkip;
+    double sampleTime = render(*set, gate, c.rate, c.format, 0, RenderPath::SAMPLE, c.seconds, bySample);
+    parseGate(c.gate, gate);
+    double blockTime  = render(*set, gate, c.rate, c.format, 0, RenderPath::BLOCK, c.seconds, byBlock);
+    parseGate(c.gate, gate);
+    double skipTime   = render(*set, gate, c.rate, c.format, 0, RenderPath::SKIP_SILENCE, c.seconds, bySkip);
+
+    uint32_t actual     = crc32(bySample.data(), bySample.size());
+    const char* status  = "ok";
+    if (crc32(byBlock.data(), byBlock.size()) != actual)    { status = "FAIL (renderBlock != renderSample)"; failures++; }
+    else if (crc32(bySkip.data(), bySkip.size()) != actual) { status = "FAIL (skipSilence != renderSample)"; failures++; }
+    else if (actual != c.crc) { status = update ? "updated" : "FAIL"; failures += update ? 0 : 1; }
+
+    std::printf("%-20s %8u %10.8x %10.8x %11.1fx %11.1fx %11.1fx  %s\n", c.name.c_str(), sampleRate, c.crc, actual,
+                realtimeMultiple(bySample.size(), sampleTime), realtimeMultiple(byBlock.size(), blockTime),
+                realtimeMultiple(bySkip.size(), skipTime), status);
+
+    char updated[512];
+    std::snprintf(updated, sizeof(updated), "%-20s %-16s %6g  %-6s %-13s %-40s %08x",
+                  c.name.c_str(), c.set.c_str(), c.seconds, c.rate ? std::to_string(c.rate).c_str() : "auto",
+                  formatName(c.format), c.gate.c_str(), actual);
+    lines.push_back(update ? std::string(updated) : line);
+  }
+
+  if (update) {
+    std::ofstream out(goldenPath);
+    for (const auto& l : lines) out << l << "\n";
+  }
+  return failures > 0 ? 1 : 0;
+}
+
+static int cmdCompare(int argc, char** argv) {
+  if (argc < 4) return 2;
+  int tolerance = argc > 5 && std::strcmp(argv[4], "--tolerance") == 0 ? std::atoi(argv[5]) : 0;
+
+  std::vector<uint8_t> a, b;
+  uint32_t rateA, rateB;
+  if (!readWav(argv[2], a, rateA) || !readWav(argv[3], b, rateB)) return 1;
+  if (rateA != rateB) {
+    std::fprintf(stderr, "Raten verschieden: %u vs. %u Hz\n", rateA, rateB);
+    return 1;
+  }
+  if (a.size() != b.size()) {
+    std::fprintf(stderr, "Längen verschieden: %zu vs. %zu Samples\n", a.size(), b.size());
+    return 1;
+  }
+
+  int    maxDiff = 0;
+  size_t differing = 0;
+  double sumSq = 0.0;
+  for (size_t i = 0; i < a.size(); ++i) {
+    int d = std::abs((int)a[i] - (int)b[i]);
+    if (d > maxDiff) maxDiff = d;
+    if (d > 0) differing++;
+    sumSq += (double)d * d;
+  }
+  double rms = a.empty() ? 0.0 : std::sqrt(sumSq / a.size());
+
+  std::printf("max |diff| %d LSB, rms %.4f LSB, %zu von %zu Samples abweichend\n", maxDiff, rms, differing, a.size());
+  return maxDiff > tolerance ? 1 : 0;
+}
+
+static int cmdBank(int argc, char** argv) {
+  if (argc < 4) return 2;
+  std::vector<TrackSet>    sets(argc - 3);
+  std::vector<std::string> names;
+  for (int i = 3; i < argc; ++i) {
+    std::string arg = argv[i];
+    size_t eq = arg.find('=');
+    if (eq == std::string::npos || eq == 0) return 2;
+    names.push_back(arg.substr(0, eq));
+    const TrackSet* set = loadSet(arg.substr(eq + 1), sets[i - 3]);
+    if (set == nullptr) return 1;
+    sets[i - 3] = *set;
+  }
+
+  std::vector<const TrackSet*> setPtrs;
+  std::vector<const char*>     namePtrs;
+  for (size_t i = 0; i < sets.size(); ++i) {
+    setPtrs.push_back(&sets[i]);
+    namePtrs.push_back(names[i].c_str());
+  }
+  // Als TrackSet-Array angelegt, damit der Puffer wie das Flash-Mapping ausgerichtet ist
+  std::vector<TrackSet> buffer(presetBankSize(sets.size()) / sizeof(TrackSet) + 1);
+  uint8_t* image = reinterpret_cast<uint8_t*>(buffer.data());
+  size_t size = encodePresetBank(setPtrs.data(), namePtrs.data(), sets.size(), image, buffer.size() * sizeof(TrackSet));
+  if (size == 0 || !mountPresetBank(image, size)) {
+    std::fprintf(stderr, "Preset-Bank ungültig (Namen: druckbares ASCII ohne \" und \\)\n");
+    return 1;
+  }
+
+  std::ofstream file(argv[2], std::ios::binary);
+  file.write((const char*)image, size);
+  if (!file) {
+    std::fprintf(stderr, "%s: Schreiben fehlgeschlagen\n", argv[2]);
+    return 1;
+  }
+  std::printf("%s: %zu Presets, %zu Bytes\n", argv[2], sets.size(), size);
+  return 0;
+}
+
+static std::string runsToString(const HonkPattern& pattern) {
+  std::string runs;
+  for (size_t i = 0; i < pattern.patternChanges.size(); ++i) {
+    if (i > 0) runs += ",";
+    runs += std::to_string(pattern.patternChanges[i]);
+  }
+  return runs.empty() ? "-" : runs;
+}
+
+static int cmdMorse(int argc, char** argv) {
+  if (argc < 3) return 2;
+  std::ifstream file(argv[2]);
+  if (!file) {
+    std::fprintf(stderr, "%s: nicht lesbar\n", argv[2]);
+    return 1;
+  }
+
+  static MorseCompiler incremental;   // behält den vorigen Fall: prüft das Neu-Übersetzen ab der Änderung
+  std::string line;
+  int failures = 0;
+  std::printf("%-20s %5s %8s %8s  %s\n", "case", "dit", "runs", "from", "");
+
+  while (std::getline(file, line)) {
+    // name dit first runs "text" – der Text reicht bis zum letzten Anführungszeichen der Zeile
+    size_t open = line.find('"');
+    size_t end  = line.rfind('"');
+    if (line.empty() || line[0] == '#' || open == std::string::npos || end == open) continue;
+
+    std::stringstream fields(line.substr(0, open));
+    std::string name, first, runs;
+    uint32_t dit;
+    if (!(fields >> name >> dit >> first >> runs)) continue;
+    std::string text = line.substr(open + 1, end - open - 1);
+
+    MorseCompiler fresh;
+    const HonkPattern& single = fresh.compile(text.data(), text.size(), dit);
+    const HonkPattern& reused = incremental.compile(text.data(), text.size(), dit);
+
+    const char* firstName = single.first == FirstSegment::FIRST_HIGH ? "HIGH" : "LOW";
+    const char* status    = "ok";
+    if (firstName != first || runsToString(single) != runs)             { status = "FAIL (Editor)"; failures++; }
+    else if (reused.first != single.first || runsToString(reused) != runs) { status = "FAIL (inkrementell)"; failures++; }
+
+    std::printf("%-20s %5u %8zu %8zu  %s\n", name.c_str(), dit, single.patternChanges.size(),
+                incremental.lastRecompiledFrom(), status);
+  }
+  return failures > 0 ? 1 : 0;
+}
+
+static int cmdAllocs(int argc, char** argv) {
+  int cycles = argc > 2 ? std::atoi(argv[2]) : 1000;
+  if (cycles <= 0) return 2;
+
+  static const char json[] =
+    "{\"tracks\":[[{\"freq\":440,\"waveform\":\"square\",\"duration\":750,\"transition\":\"none\"},{\"freq\":0,\"duration\":100}],"
+    "[{\"freq\":550,\"waveform\":\"sine\",\"duration\":70000,\"transition\":\"exp\"}],[],[]]}";
+  static const char* messages[] = { "SOS", "SOS DE DL1ABC", "HELLO WORLD \xC3\x84\xC3\x96\xC3\x9C" };
+  static const uint32_t gateRuns[] = { 25, 400, 25, 200, 20, 100 };
+  static TrackJsonParser parser;
+  static MorseCompiler   morse;
+  uint8_t binary[TRACKS_BINARY_MAX_SIZE];
+  uint8_t block[RENDER_BLOCK_SIZE];
+
+  // Vorlauf außerhalb der Zählung: erster Satz, Quelle übernommen
+  selectTracks(TrackSource::USER);
+  renderBlock(block, RENDER_BLOCK_SIZE);
+
+  int failures = 0;
+  countAllocations = true;
+  for (int i = 0; i < cycles; ++i) {
+    TrackSet* set = acquireTrackSet();
+    if (set == nullptr) {
+      failures++;
+    } else {
+      parser.begin(*set);
+      parser.feed(json, sizeof(json) - 1);
+      if (!parser.finish()) failures++;
+      size_t len = encodeTracksBinary(*set, binary, sizeof(binary));
+      if (!decodeTracksBinary(binary, len, *set)) failures++;
+      compileTimeline(*set);
+      publishTracks(set);
+    }
+
+    SegmentPatch patch = {};
+    patch.track        = 0;
+    patch.segment      = 1;
+    patch.fields       = PATCH_FREQ;
+    patch.values.freq  = 300.0f + (float)(i % 7);
+    if (!queueSegmentPatch(patch)) failures++;
+
+    GatePattern* gate = compileGate(i & 1, gateRuns, sizeof(gateRuns) / sizeof(gateRuns[0]));
+    if (gate == nullptr) failures++;
+    else publishGate(gate);
+
+    const char* text = messages[i % 3];
+    morse.compile(text, std::strlen(text), MORSE_DIT_MS);
+
+    for (int b = 0; b < 400; ++b) renderBlock(block, RENDER_BLOCK_SIZE);
+  }
+  countAllocations = false;
+  publishGate(nullptr);
+  renderBlock(block, RENDER_BLOCK_SIZE);
+
+  std::printf("%d Zyklen: %ld operator new, %d Fehlschläge (Pool voll / Parser)  %s\n", cycles, allocationCount,
+              failures, allocationCount == 0 && failures == 0 ? "ok" : "FAIL");
+  return allocationCount == 0 && failures == 0 ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+  initSynth();
+
+  int result = 2;
+  if (argc > 1) {
+    if (std::strcmp(argv[1], "render") == 0)  result = cmdRender(argc, argv);
+    if (std::strcmp(argv[1], "check") == 0)   result = cmdCheck(argc, argv);
+    if (std::strcmp(argv[1], "compare") == 0) result = cmdCompare(argc, argv);
+    if (std::strcmp(argv[1], "bank") == 0)    result = cmdBank(argc, argv);
+    if (std::strcmp(argv[1], "morse") == 0)   result = cmdMorse(argc, argv);
+    if (std::strcmp(argv[1], "allocs") == 0)  result = cmdAllocs(argc, argv);
+  }
+  if (result == 2) {
+    std::fprintf(stderr,
+                 "render <satz> <sekunden> <out.wav> [--gate open|closed:ms,...] [--rate hz] [--start ms] [--block]\n"
+                 "       [--fixed] [--dither]\n"
+                 "check <golden.txt> [--update]\n"
+                 "compare <a.wav> <b.wav> [--tolerance n]\n"
+                 "bank <out.bin> <name>=<satz> ...\n"
+                 "morse <golden.txt>\n"
+                 "allocs [zyklen]\n");
+  }
+  return result;
+}
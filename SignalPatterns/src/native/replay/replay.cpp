@@ -0,0 +1,859 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../../control.h"
+#include "../../platform.h"
+#include "../../preset_bank.h"
+#include "../../synth.h"
+
+// --------------------------------------
+// GPIO-Trace-Replay (native_replay-Env)
+// --------------------------------------
+// pio run -e native_replay && .pio/build/native_replay/program <befehl> ...
+//
+//   run <trace> [--bank bank.bin] [--edges]
+//       Spielt einen Eingangs-Trace durch die Steuerung des Geräts (control.cpp: Entprellung,
+//       controlAudioOutput() und alles darunter) und die Engine, gegen simulierte Zeit, Pins und
+//       Tasks. Gemessen wird je Reaktion die Zeit von der ersten Flanke bis zur ersten geänderten
+//       Ausgabe, dazu die Operationen am DAC-Task. --edges listet jede Reaktion einzeln.
+//   check <golden.txt> [--update]
+//       Spielt jeden Fall und vergleicht Median und Maximum der Latenz sowie die Task-Operationen mit
+//       den eingetragenen Werten. Exit-Code 1, wenn etwas schlechter geworden ist; --update schreibt
+//       die aktuellen Werte zurück.
+//
+// Trace (Text, # = Kommentar), Zeiten in ms ab dem Einschalten:
+//   start <eingang> <pegel>                          Pegel beim Einschalten (sonst Ruhepegel)
+//   <ms> <eingang> <pegel> [prellen <flanken> <ms>]  Flanke; mit "prellen" ein Burst aus so vielen
+//                                                    Flanken über die Dauer, der auf <pegel> endet
+//   ende <ms>                                        Ende der Simulation (sonst letzte Flanke + 2 s)
+//   rechenzeit <us>                                  Dauer einer Controller-Runde (sonst 0), s. u.
+// <eingang> ist SIGNAL_ENABLE, SIGNAL_SELECT, HORN_ENABLE, HONK_EMERGENCY, PRESET_BIT0..2 oder die
+// GPIO-Nummer (aufgezeichnete Traces), <pegel> 0/1 oder LOW/HIGH. Zeilen ohne Pegelwechsel entfallen.
+//
+// Modell (deterministisch, Rechenzeit 0 außer mit "rechenzeit"):
+// - Die ISR merkt sich wie onInputEdge() je Eingang die erste Flanke seit der letzten Übernahme und
+//   weckt den Controller-Task; der läuft sofort und übernimmt sie wie takeInputEdges(). Auf das Ende
+//   der Ruhezeit wartet er wie auf dem Gerät in ganzen FreeRTOS-Ticks (ulTaskNotifyTake()).
+// - Mit "rechenzeit" liest eine Runde die Uhr zu Beginn; Flanken bis zu ihrem Ende treffen im
+//   ungünstigsten Fall ein, nachdem nowUs gelesen ist und bevor settleInputs() die Eingänge prüft.
+//   Ihre Notification startet direkt danach die nächste Runde.
+// - Ausgabe wie AudioOutputMode::I2S_DMA: Der DAC-Task rendert einen Block und wartet in i2s_write,
+//   bis einer der REPLAY_DMA_BUFFERS Puffer frei ist. Nach dem Start liegen davor noch
+//   REPLAY_DMA_BUFFERS - 1 genullte Puffer (wie bei noteFirstSound()). Pausieren hält DMA und Task
+//   samt Inhalt an, Fortsetzen spielt den Rest zuerst.
+// - Der Horn-Task schaltet beim Wecken nur den ersten Abschnitt des Musters; die weiteren Abschnitte
+//   werden nicht simuliert.
+// Eine Reaktion ist hörbar, sobald das Relais schaltet, die Ausgabe verstummt oder der DAC den ersten
+// Block spielt, der nach der Entscheidung gerendert wurde.
+
+// Entspricht AUDIO_BLOCK_SIZE, AUDIO_DMA_BUFFER_COUNT und der FreeRTOS-Tickrate auf dem Gerät
+constexpr size_t  REPLAY_BLOCK_SIZE  = 256;
+constexpr size_t  REPLAY_DMA_BUFFERS = 4;
+constexpr int64_t REPLAY_TICK_US     = 1000;
+constexpr int64_t REPLAY_TAIL_MS     = 2000;   // Nachlauf nach der letzten Flanke
+constexpr int64_t NEVER              = INT64_MAX;
+
+// Vorgabe-Hupenmuster des Geräts (emergencyHonkPattern in main.cpp), beginnt mit Ton
+static const uint32_t REPLAY_HONK_PATTERN[] = { 25, 400, 25, 200, 20, 100, 25, 50, 25, 25, 25, 13, 25, 12, 25, 500 };
+
+static const char* const INPUT_NAMES[INPUT_COUNT] = {
+  "SIGNAL_ENABLE", "SIGNAL_SELECT", "HORN_ENABLE", "HONK_EMERGENCY", "PRESET_BIT0", "PRESET_BIT1", "PRESET_BIT2"
+};
+
+// Ruhepegel wie in setupInputs(): SIGNAL_ENABLE/SIGNAL_SELECT mit Pull-down, der Rest mit Pull-up
+static const uint8_t IDLE_LEVELS[INPUT_COUNT] = { PIN_LOW, PIN_LOW, PIN_HIGH, PIN_HIGH, PIN_HIGH, PIN_HIGH, PIN_HIGH };
+
+// --------------------------------------
+// Trace
+// --------------------------------------
+
+struct TraceEdge {
+  int64_t timeUs;
+  uint8_t input;
+  uint8_t level;
+};
+
+struct Trace {
+  uint8_t                startLevels[INPUT_COUNT];
+  std::vector<TraceEdge> edges;
+  int64_t                endUs;
+  int64_t                computeUs;   // Dauer einer Controller-Runde
+};
+
+static bool parseInput(const std::string& name, uint8_t& input) {
+  for (uint8_t i = 0; i < INPUT_COUNT; ++i) {
+    if (name == INPUT_NAMES[i]) { input = i; return true; }
+  }
+  if (name.empty() || name.find_first_not_of("0123456789") != std::string::npos) return false;
+  int pin = std::atoi(name.c_str());
+  for (uint8_t i = 0; i < INPUT_COUNT; ++i) {
+    if (inputs[i].pin == pin) { input = i; return true; }
+  }
+  return false;
+}
+
+static bool parseLevel(const std::string& text, uint8_t& level) {
+  if (text == "0" || text == "LOW")  { level = PIN_LOW;  return true; }
+  if (text == "1" || text == "HIGH") { level = PIN_HIGH; return true; }
+  return false;
+}
+
+static int64_t msToUs(double ms) {
+  return (int64_t)(ms * 1000.0 + 0.5);
+}
+
+// Prell-Burst ab timeUs über spanUs: abwechselnde Flanken ab dem Pegel current, die letzte genau bei
+// timeUs + spanUs auf level. Die Abstände kommen aus einem festen LCG, jeder Lauf sieht dieselben.
+static void addBounce(std::vector<TraceEdge>& edges, int64_t timeUs, uint8_t input, uint8_t current, uint8_t level,
+                      int count, int64_t spanUs, uint32_t seed) {
+  if (count < 1) count = 1;
+  if ((count % 2 == 1) != (current != level)) count++;   // sonst endet der Burst auf dem falschen Pegel
+
+  std::vector<int64_t> offsets(count, 0);
+  uint32_t state = seed * 2654435761u + 1;
+  for (int k = 1; k < count; ++k) {
+    state = state * 1664525u + 1013904223u;
+    offsets[k] = (int64_t)(state >> 8) % (spanUs + 1);
+  }
+  std::sort(offsets.begin(), offsets.end());
+  offsets.back() = spanUs;
+
+  uint8_t pinLevel = current;
+  for (int k = 0; k < count; ++k) {
+    pinLevel = pinLevel == PIN_HIGH ? PIN_LOW : PIN_HIGH;
+    edges.push_back({ timeUs + offsets[k], input, pinLevel });
+  }
+}
+
+static bool parseTraceLine(const std::string& line, int lineNo, Trace& trace, uint8_t* level, bool& started) {
+  std::stringstream fields(line);
+  std::string first, name, levelText;
+  if (!(fields >> first)) return true;
+
+  if (first == "ende") {
+    double ms;
+    if (!(fields >> ms) || ms < 0.0) return false;
+    trace.endUs = msToUs(ms);
+    return true;
+  }
+  if (first == "rechenzeit") {
+    double us;
+    if (!(fields >> us) || us < 0.0) return false;
+    trace.computeUs = (int64_t)(us + 0.5);
+    return true;
+  }
+
+  uint8_t input, target;
+  if (!(fields >> name >> levelText) || !parseInput(name, input) || !parseLevel(levelText, target)) return false;
+
+  if (first == "start") {
+    if (started) return false;   // nur vor der ersten Flanke
+    trace.startLevels[input] = target;
+    return true;
+  }
+  if (!started) {
+    std::memcpy(level, trace.startLevels, INPUT_COUNT);
+    started = true;
+  }
+
+  char* end;
+  double ms = std::strtod(first.c_str(), &end);
+  if (*end != '\0' || ms < 0.0) return false;
+  int64_t timeUs = msToUs(ms);
+  if (!trace.edges.empty() && timeUs < trace.edges.back().timeUs) return false;
+
+  std::string bounce;
+  if (fields >> bounce) {
+    int    count;
+    double spanMs;
+    if (bounce != "prellen" || !(fields >> count >> spanMs) || spanMs < 0.0) return false;
+    addBounce(trace.edges, timeUs, input, level[input], target, count, msToUs(spanMs), (uint32_t)lineNo);
+  } else if (level[input] != target) {
+    trace.edges.push_back({ timeUs, input, target });
+  }
+  level[input] = target;
+  return true;
+}
+
+static bool loadTrace(const std::string& path, Trace& trace) {
+  std::ifstream file(path);
+  if (!file) {
+    std::fprintf(stderr, "%s: nicht lesbar\n", path.c_str());
+    return false;
+  }
+  std::memcpy(trace.startLevels, IDLE_LEVELS, sizeof(trace.startLevels));
+  trace.edges.clear();
+  trace.endUs     = NEVER;
+  trace.computeUs = 0;
+
+  uint8_t level[INPUT_COUNT];
+  bool started = false;
+  std::string line;
+  int lineNo = 0;
+  while (std::getline(file, line)) {
+    lineNo++;
+    size_t comment = line.find('#');
+    if (comment != std::string::npos) line.resize(comment);
+    if (!parseTraceLine(line, lineNo, trace, level, started)) {
+      std::fprintf(stderr, "%s:%d: ungültige Zeile\n", path.c_str(), lineNo);
+      return false;
+    }
+  }
+
+  if (trace.endUs == NEVER) trace.endUs = (trace.edges.empty() ? 0 : trace.edges.back().timeUs) + REPLAY_TAIL_MS * 1000;
+  return true;
+}
+
+// --------------------------------------
+// Simulation
+// --------------------------------------
+
+enum class ReactionKind : uint8_t { NONE, START, SWITCH, STOP, HORN };
+static const char* const KIND_NAMES[] = { "-", "start", "wechsel", "stopp", "horn" };
+
+struct Reaction {
+  int64_t      firstEdgeUs;
+  int64_t      decisionUs;
+  int64_t      audibleUs;     // -1: (noch) nicht hörbar
+  uint32_t     generation;    // Blöcke ab dieser Generation sind nach der Entscheidung gerendert
+  uint8_t      inputs;        // Bitmaske der übernommenen Eingänge
+  bool         boot;
+  bool         superseded;    // vor dem Hörbarwerden von der nächsten Entscheidung abgelöst
+  ReactionKind kind;
+  // von den Hooks während der Entscheidung gesetzt
+  bool         silenced;
+  bool         relaySwitched;
+  bool         dacStarted;
+  unsigned     taskOps;
+};
+
+struct TaskCounts {
+  unsigned creates;
+  unsigned deletes;
+  unsigned suspends;
+  unsigned resumes;
+};
+
+struct DmaBlock {
+  uint32_t samples;
+  uint32_t generation;
+};
+
+// Zustand eines Laufs; die Hooks unten arbeiten darauf
+struct Simulation {
+  int64_t               nowUs;
+  uint8_t               pins[INPUT_COUNT];
+  uint32_t              generation;
+  Reaction*             current;           // Entscheidung, die gerade läuft
+  std::vector<Reaction> reactions;
+  unsigned              series;            // Flanken-Serien (erste Flanke bis Übernahme)
+  unsigned              bounceOnly;        // davon ohne Pegelwechsel
+
+  int64_t               controllerWakeUs;  // Timeout von ulTaskNotifyTake
+  bool                  edgePending[INPUT_COUNT];   // wie in main.cpp, von der ISR gesetzt
+  uint32_t              edgeFirstUs[INPUT_COUNT];
+
+  // DAC-Task + I2S-DMA
+  bool                  taskExists;
+  bool                  taskSuspended;
+  bool                  holding;           // gerenderter Block wartet in i2s_write
+  DmaBlock              held;
+  std::deque<DmaBlock>  dma;               // dma.front() spielt
+  bool                  i2sRunning;
+  int64_t               headEndUs;         // I2S läuft: Ende von dma.front()
+  int64_t               headLeftUs;        // I2S steht: Rest von dma.front()
+  uint32_t              i2sRate;
+  int64_t               pausedAtUs;        // wie dacPausedAtUs in main.cpp, 0 = keine Pause
+  TaskCounts            tasks;
+
+  // Horn
+  bool                  relay;             // GPIO_HORN LOW
+  bool                  hornNotified;
+};
+
+static Simulation sim;
+
+static int64_t blockUs(uint32_t samples) {
+  return (int64_t)samples * 1000000 / sim.i2sRate;
+}
+
+static void noteTaskOp() {
+  if (sim.current != nullptr) sim.current->taskOps++;
+}
+
+// Block beginnt zu spielen: offene Reaktionen, deren Generation er trägt, sind jetzt hörbar
+static void blockStarts(const DmaBlock& block) {
+  for (Reaction& r : sim.reactions) {
+    if (r.audibleUs < 0 && !r.superseded && r.kind != ReactionKind::NONE && block.generation >= r.generation) {
+      r.audibleUs = sim.nowUs;
+    }
+  }
+}
+
+// dacBlockLoop(): Block rendern (bzw. Stille überspringen) und an i2s_write übergeben, bis die
+// DMA-Kette voll ist
+static void runDacTask() {
+  static uint8_t block[REPLAY_BLOCK_SIZE];
+  while (sim.taskExists && !sim.taskSuspended) {
+    if (!sim.holding) {
+      uint32_t count;
+      if (silentSamplesAhead() >= REPLAY_BLOCK_SIZE) {
+        skipSilence(REPLAY_BLOCK_SIZE);
+        count = REPLAY_BLOCK_SIZE;
+      } else {
+        count = (uint32_t)renderBlock(block, REPLAY_BLOCK_SIZE);
+      }
+      reclaimRetiredTracks();
+      reclaimRetiredGate();
+      sim.i2sRate = sampleRate;   // i2s_set_sample_rates()
+      sim.held    = { count, sim.generation };
+      sim.holding = true;
+    }
+    if (sim.dma.size() >= REPLAY_DMA_BUFFERS) return;   // wartet in i2s_write
+
+    sim.dma.push_back(sim.held);
+    sim.holding = false;
+    if (sim.dma.size() == 1 && sim.i2sRunning) {         // DMA war leergelaufen
+      sim.headEndUs = sim.nowUs + blockUs(sim.held.samples);
+      blockStarts(sim.held);
+    }
+  }
+}
+
+static void dmaBlockEnds() {
+  sim.dma.pop_front();
+  if (!sim.dma.empty()) {
+    sim.headEndUs = sim.nowUs + blockUs(sim.dma.front().samples);
+    blockStarts(sim.dma.front());
+  }
+  runDacTask();
+}
+
+// Horn-Task nach xTaskNotify (niedrigere Priorität als der Controller): Relais auf den ersten
+// Abschnitt des Musters bzw. aus
+static void runHornTask() {
+  sim.hornNotified = false;
+  if (honkPatternActive && !synthesizeHorn()) playRealHorn();
+  else stopRealHorn();
+}
+
+// --------------------------------------
+// Hooks (control.h)
+// --------------------------------------
+
+uint8_t readInputPin(uint8_t pin) {
+  for (uint8_t i = 0; i < INPUT_COUNT; ++i) {
+    if (inputs[i].pin == pin) return sim.pins[i];
+  }
+  return PIN_LOW;
+}
+
+bool dacTaskRunning() {
+  return sim.taskExists;
+}
+
+void startDacTask() {
+  if (sim.taskExists) return;   // startTask(): Handle schon gesetzt
+  sim.tasks.creates++;
+  noteTaskOp();
+  sim.taskExists    = true;
+  sim.taskSuspended = false;
+  sim.holding       = false;
+  if (sim.current != nullptr) sim.current->dacStarted = true;
+
+  // i2s_zero_dma_buffer() + i2s_start() am Anfang von dacBlockLoop()
+  sim.i2sRate = sampleRate;
+  sim.dma.assign(REPLAY_DMA_BUFFERS - 1, DmaBlock{ REPLAY_BLOCK_SIZE, 0 });
+  sim.i2sRunning = true;
+  sim.headEndUs  = sim.nowUs + blockUs(REPLAY_BLOCK_SIZE);
+  runDacTask();
+}
+
+void pauseDacOutput() {
+  if (!sim.taskExists) return;   // pauseTask() ohne Handle, I2S steht schon
+  if (sim.pausedAtUs == 0) sim.pausedAtUs = sim.nowUs;
+  if (!sim.taskSuspended) {
+    sim.tasks.suspends++;
+    noteTaskOp();
+    sim.taskSuspended = true;
+  }
+  if (sim.i2sRunning) {
+    sim.i2sRunning = false;
+    sim.headLeftUs = sim.dma.empty() ? 0 : sim.headEndUs - sim.nowUs;
+    if (sim.current != nullptr) sim.current->silenced = true;
+  }
+}
+
+void resumeDacOutput() {
+  if (sim.pausedAtUs != 0) {
+    advancePlayback((uint32_t)((sim.nowUs - sim.pausedAtUs) / 1000));
+    sim.pausedAtUs = 0;
+  }
+  if (!sim.taskExists) return;
+  if (!sim.i2sRunning) {
+    sim.i2sRunning = true;
+    sim.headEndUs  = sim.nowUs + sim.headLeftUs;
+    if (sim.current != nullptr) sim.current->dacStarted = true;
+  }
+  if (sim.taskSuspended) {
+    sim.tasks.resumes++;
+    noteTaskOp();
+    sim.taskSuspended = false;
+  }
+  runDacTask();
+}
+
+void stopDacOutput() {
+  if (sim.taskExists) {
+    sim.tasks.deletes++;
+    noteTaskOp();
+    sim.taskExists = false;
+  }
+  sim.holding    = false;
+  sim.pausedAtUs = 0;
+  if (sim.i2sRunning) {
+    sim.i2sRunning = false;
+    if (sim.current != nullptr) sim.current->silenced = true;
+  }
+}
+
+void playRealHorn() {
+  if (!sim.relay && sim.current != nullptr) sim.current->relaySwitched = true;
+  sim.relay = true;
+}
+
+void stopRealHorn() {
+  if (sim.relay && sim.current != nullptr) sim.current->relaySwitched = true;
+  sim.relay = false;
+}
+
+void publishHonkPattern() {
+  GatePattern* gate = compileGate(true, REPLAY_HONK_PATTERN, sizeof(REPLAY_HONK_PATTERN) / sizeof(REPLAY_HONK_PATTERN[0]));
+  if (gate != nullptr) publishGate(gate);
+  notifyHornTask();
+}
+
+void notifyHornTask() {
+  sim.hornNotified = true;
+}
+
+// --------------------------------------
+// Ablauf
+// --------------------------------------
+
+static void resetSimulation(const Trace& trace) {
+  sim.nowUs            = 0;
+  sim.generation       = 0;
+  sim.current          = nullptr;
+  sim.reactions.clear();
+  sim.series           = 0;
+  sim.bounceOnly       = 0;
+  sim.controllerWakeUs = NEVER;
+  sim.taskExists       = false;
+  sim.taskSuspended    = false;
+  sim.holding          = false;
+  sim.dma.clear();
+  sim.i2sRunning       = false;
+  sim.headEndUs        = 0;
+  sim.headLeftUs       = 0;
+  sim.i2sRate          = sampleRate;
+  sim.pausedAtUs       = 0;
+  sim.tasks            = {};
+  sim.relay            = false;
+  sim.hornNotified     = false;
+  std::memcpy(sim.pins, trace.startLevels, sizeof(sim.pins));
+  std::memset(sim.edgePending, 0, sizeof(sim.edgePending));
+
+  // Engine wie nach dem Booten: Nutzersatz, Gate offen und eingeschwungen, Schleife von vorn
+  uint8_t settle[64];
+  selectPreset(nullptr);
+  selectTracks(TrackSource::USER);
+  publishGate(nullptr);
+  for (uint32_t n = 0; n <= sampleRate * GATE_RAMP_MS / 1000; n += sizeof(settle)) renderBlock(settle, sizeof(settle));
+  reclaimRetiredTracks();
+  reclaimRetiredGate();
+  initTracks();
+
+  // setupInputs(): Pegel gelesen, noch nichts ausgewertet
+  honkPatternActive = false;
+  selectedPreset.store(-1);
+  for (uint8_t i = 0; i < INPUT_COUNT; ++i) {
+    inputs[i].state        = sim.pins[i];
+    inputs[i].handledState = sim.pins[i];
+    inputs[i].settling     = false;
+    inputs[i].firstEdgeUs  = 0;
+    inputs[i].lastEdgeUs   = 0;
+  }
+}
+
+// Eine Entscheidung der Steuerung mit allem, was sie auslöst. Blöcke, die der DAC-Task ab hier
+// rendert, tragen die neue Generation.
+static void decide(int64_t firstEdgeUs, uint8_t changedInputs, bool boot) {
+  for (Reaction& r : sim.reactions) {
+    if (r.audibleUs < 0 && r.kind != ReactionKind::NONE) r.superseded = true;
+  }
+
+  Reaction r = {};
+  r.firstEdgeUs = firstEdgeUs;
+  r.decisionUs  = sim.nowUs;
+  r.audibleUs   = -1;
+  r.generation  = ++sim.generation;
+  r.inputs      = changedInputs;
+  r.boot        = boot;
+
+  TrackSource     source = requestedSource.load();
+  const TrackSet* preset = requestedPreset.load();
+  GatePattern*    gate   = pendingGate.load();
+
+  sim.current = &r;
+  if (boot) applyInputsAtBoot();
+  else controlAudioOutput();
+  if (sim.hornNotified) runHornTask();
+  sim.current = nullptr;
+
+  // Hört man den Wechsel? Ein anderes Preset nur, wenn es auch gespielt wird
+  TrackSource next = requestedSource.load();
+  bool soundChanged = next != source || (next == TrackSource::PRESET && requestedPreset.load() != preset)
+                      || pendingGate.load() != gate;
+  bool playing = sim.taskExists && !sim.taskSuspended && sim.i2sRunning;
+
+  if (r.relaySwitched && sim.relay)       r.kind = ReactionKind::HORN;
+  else if (r.relaySwitched || r.silenced) r.kind = ReactionKind::STOP;
+  else if (playing && r.dacStarted)       r.kind = ReactionKind::START;
+  else if (playing && soundChanged)       r.kind = ReactionKind::SWITCH;
+  else                                    r.kind = ReactionKind::NONE;
+  if (r.kind == ReactionKind::HORN || r.kind == ReactionKind::STOP) r.audibleUs = sim.nowUs;
+
+  sim.reactions.push_back(r);
+}
+
+// onInputEdge(): Pin, lastEdgeUs und die erste Flanke seit der letzten Übernahme
+static void inputEdge(const TraceEdge& edge) {
+  sim.pins[edge.input]          = edge.level;
+  inputs[edge.input].lastEdgeUs = (uint32_t)edge.timeUs;
+  if (!sim.edgePending[edge.input]) {
+    sim.edgeFirstUs[edge.input] = (uint32_t)edge.timeUs;
+    sim.edgePending[edge.input] = true;
+  }
+}
+
+// takeInputEdges(): gemerkte Flanken an die Entprellung
+static void takeInputEdges() {
+  for (uint8_t i = 0; i < INPUT_COUNT; ++i) {
+    if (!sim.edgePending[i]) continue;
+    if (!inputs[i].settling) sim.series++;
+    sim.edgePending[i] = false;
+    noteInputEdge(i, sim.edgeFirstUs[i]);
+  }
+}
+
+// Controller-Task: eine Runde nach ulTaskNotifyTake (Notification der ISR oder Timeout). Flanken
+// während der Rechenzeit übernimmt die ISR hier aus dem Trace (next).
+static void controllerStep(const Trace& trace, size_t& next) {
+  takeInputEdges();
+  const int64_t roundUs = sim.nowUs;   // esp_timer_get_time() vor settleInputs()
+
+  uint8_t before[INPUT_COUNT];
+  bool    settling[INPUT_COUNT];
+  for (uint8_t i = 0; i < INPUT_COUNT; ++i) {
+    before[i]   = inputs[i].state;
+    settling[i] = inputs[i].settling;
+  }
+
+  bool notified = false;
+  while (trace.computeUs > 0 && next < trace.edges.size() && trace.edges[next].timeUs <= roundUs + trace.computeUs) {
+    inputEdge(trace.edges[next++]);
+    notified = true;
+  }
+
+  uint32_t firstEdgeUs = 0;
+  uint32_t waitUs;
+  bool changed = settleInputs((uint32_t)roundUs, waitUs, firstEdgeUs);
+
+  // wie main.cpp: aufgerundete ms + 1 Tick, geweckt vom Tick-Interrupt; eine Notification aus der
+  // Runde weckt sofort nach ihrem Ende
+  if (notified) {
+    sim.controllerWakeUs = roundUs + trace.computeUs;
+  } else if (waitUs == UINT32_MAX) {
+    sim.controllerWakeUs = NEVER;
+  } else {
+    int64_t ticks = (waitUs + 999) / 1000 + 1;
+    sim.controllerWakeUs = (sim.nowUs / REPLAY_TICK_US + ticks) * REPLAY_TICK_US;
+  }
+
+  uint8_t mask = 0;
+  for (uint8_t i = 0; i < INPUT_COUNT; ++i) {
+    if (!settling[i] || inputs[i].settling) continue;   // Serie nicht in dieser Runde übernommen
+    if (inputs[i].state != before[i]) mask |= 1 << i;
+    else sim.bounceOnly++;
+  }
+  if (changed) decide(firstEdgeUs, mask, false);
+}
+
+static void simulate(const Trace& trace) {
+  resetSimulation(trace);
+  decide(0, 0, true);
+
+  size_t next = 0;
+  while (true) {
+    int64_t edgeUs = next < trace.edges.size() ? trace.edges[next].timeUs : NEVER;
+    int64_t dmaUs  = sim.i2sRunning && !sim.dma.empty() ? sim.headEndUs : NEVER;
+    int64_t t      = std::min(std::min(edgeUs, dmaUs), sim.controllerWakeUs);
+    if (t == NEVER || t > trace.endUs) break;
+    sim.nowUs = t;
+
+    if (dmaUs == t) {
+      dmaBlockEnds();
+    } else if (edgeUs == t) {
+      // ISR; ihre Notification weckt den Controller-Task, der Vorrang hat und sofort läuft
+      inputEdge(trace.edges[next++]);
+      controllerStep(trace, next);
+    } else {
+      controllerStep(trace, next);
+    }
+  }
+}
+
+// --------------------------------------
+// Auswertung
+// --------------------------------------
+
+struct Summary {
+  size_t     reactions;   // gemessene Reaktionen (ohne Boot)
+  size_t     noEffect;
+  size_t     superseded;
+  int64_t    p50Us;
+  int64_t    maxUs;
+  TaskCounts tasks;
+};
+
+static bool measured(const Reaction& r) {
+  return !r.superseded && r.kind != ReactionKind::NONE && r.audibleUs >= 0;
+}
+
+static int64_t percentile(std::vector<int64_t> values, double p) {
+  if (values.empty()) return 0;
+  std::sort(values.begin(), values.end());
+  return values[(size_t)(p * (values.size() - 1) + 0.5)];
+}
+
+// Latenzen der Boot-Reaktion bzw. aller Reaktionen einer Art (NONE = alle)
+static std::vector<int64_t> latencies(bool boot, ReactionKind kind) {
+  std::vector<int64_t> values;
+  for (const Reaction& r : sim.reactions) {
+    if (r.boot != boot || !measured(r)) continue;
+    if (kind == ReactionKind::NONE || r.kind == kind) values.push_back(r.audibleUs - r.firstEdgeUs);
+  }
+  return values;
+}
+
+static Summary summarize() {
+  Summary s = {};
+  for (const Reaction& r : sim.reactions) {
+    if (r.boot) continue;
+    if (r.kind == ReactionKind::NONE) s.noEffect++;
+    else if (r.superseded)            s.superseded++;
+  }
+  std::vector<int64_t> all = latencies(false, ReactionKind::NONE);
+  s.reactions = all.size();
+  s.p50Us     = percentile(all, 0.50);
+  s.maxUs     = all.empty() ? 0 : *std::max_element(all.begin(), all.end());
+  s.tasks     = sim.tasks;
+  return s;
+}
+
+static void printLatencyRow(const char* name, const std::vector<int64_t>& values) {
+  if (values.empty()) return;
+  std::printf("%-10s %6zu %9.3f %9.3f %9.3f %9.3f\n", name, values.size(),
+              *std::min_element(values.begin(), values.end()) / 1000.0, percentile(values, 0.50) / 1000.0,
+              percentile(values, 0.95) / 1000.0, *std::max_element(values.begin(), values.end()) / 1000.0);
+}
+
+static void printReactions() {
+  std::printf("%10s %10s %10s  %-8s %5s  %s\n", "flanke ms", "entsch ms", "latenz ms", "art", "tasks", "eingänge");
+  for (const Reaction& r : sim.reactions) {
+    std::string names = r.boot ? "boot" : "";
+    for (uint8_t i = 0; i < INPUT_COUNT; ++i) {
+      if (r.inputs & (1 << i)) names += (names.empty() ? "" : ",") + std::string(INPUT_NAMES[i]);
+    }
+    char latency[16];
+    if (r.superseded)      std::snprintf(latency, sizeof(latency), "abgelöst");
+    else if (!measured(r)) std::snprintf(latency, sizeof(latency), "-");
+    else                   std::snprintf(latency, sizeof(latency), "%.3f", (r.audibleUs - r.firstEdgeUs) / 1000.0);
+    std::printf("%10.3f %10.3f %10s  %-8s %5u  %s\n", r.firstEdgeUs / 1000.0, r.decisionUs / 1000.0, latency,
+                KIND_NAMES[(uint8_t)r.kind], r.taskOps, names.c_str());
+  }
+  std::printf("\n");
+}
+
+// Bank für PRESET_BIT0..2 einbinden ("-" = keine, nur der Nutzersatz)
+static bool mountBank(const std::string& path) {
+  if (path == "-") {
+    mountPresetBank(nullptr, 0);
+    return true;
+  }
+  size_t size;
+  const uint8_t* image = platformMapReadOnly(path.c_str(), size);
+  if (image == nullptr || !mountPresetBank(image, size)) {
+    std::fprintf(stderr, "%s: keine gültige Preset-Bank\n", path.c_str());
+    return false;
+  }
+  return true;
+}
+
+// --------------------------------------
+// Befehle
+// --------------------------------------
+
+static int cmdRun(int argc, char** argv) {
+  if (argc < 3) return 2;
+  std::string bank = "-";
+  bool edges = false;
+  for (int i = 3; i < argc; ++i) {
+    if (std::strcmp(argv[i], "--edges") == 0) edges = true;
+    else if (std::strcmp(argv[i], "--bank") == 0 && i + 1 < argc) bank = argv[++i];
+    else return 2;
+  }
+
+  Trace trace;
+  if (!loadTrace(argv[2], trace) || !mountBank(bank)) return 1;
+  simulate(trace);
+
+  if (edges) printReactions();
+  std::printf("%-10s %6s %9s %9s %9s %9s\n", "reaktion", "anzahl", "min ms", "p50 ms", "p95 ms", "max ms");
+  printLatencyRow("boot", latencies(true, ReactionKind::NONE));
+  for (uint8_t k = (uint8_t)ReactionKind::START; k <= (uint8_t)ReactionKind::HORN; ++k) {
+    printLatencyRow(KIND_NAMES[k], latencies(false, (ReactionKind)k));
+  }
+  printLatencyRow("alle", latencies(false, ReactionKind::NONE));
+
+  Summary s = summarize();
+  std::printf("\n%zu Flanken in %u Serien (%u nur geprellt), %zu ohne hörbare Wirkung, %zu abgelöst\n",
+              trace.edges.size(), sim.series, sim.bounceOnly, s.noEffect, s.superseded);
+  std::printf("DAC-Task: %u erzeugt, %u gelöscht, %u angehalten, %u fortgesetzt\n", s.tasks.creates, s.tasks.deletes,
+              s.tasks.suspends, s.tasks.resumes);
+  return 0;
+}
+
+struct ReplayCase {
+  std::string name;
+  std::string trace;
+  std::string bank;       // "-" = keine
+  size_t      reactions;
+  int64_t     p50Us;
+  int64_t     maxUs;
+  TaskCounts  tasks;
+};
+
+static bool parseCaseLine(const std::string& line, ReplayCase& c) {
+  std::stringstream fields(line);
+  double p50Ms, maxMs;
+  if (!(fields >> c.name >> c.trace >> c.bank >> c.reactions >> p50Ms >> maxMs >> c.tasks.creates >> c.tasks.deletes
+        >> c.tasks.suspends >> c.tasks.resumes)) {
+    return false;
+  }
+  c.p50Us = msToUs(p50Ms);
+  c.maxUs = msToUs(maxMs);
+  return true;
+}
+
+// Schlechter heißt mehr Latenz oder mehr Task-Operationen; eine andere Zahl gemessener Reaktionen
+// heißt, dass sich das Verhalten geändert hat
+static const char* compareCase(const ReplayCase& c, const Summary& s, bool& worse) {
+  const TaskCounts& a = s.tasks;
+  const TaskCounts& e = c.tasks;
+  worse = true;
+  if (s.reactions != c.reactions) return "FAIL (Reaktionen)";
+  if (s.p50Us > c.p50Us || s.maxUs > c.maxUs) return "FAIL (Latenz)";
+  if (a.creates > e.creates || a.deletes > e.deletes || a.suspends > e.suspends || a.resumes > e.resumes) {
+    return "FAIL (Task-Operationen)";
+  }
+  worse = false;
+  if (s.p50Us < c.p50Us || s.maxUs < c.maxUs || a.creates < e.creates || a.deletes < e.deletes
+      || a.suspends < e.suspends || a.resumes < e.resumes) {
+    return "besser (--update)";
+  }
+  return "ok";
+}
+
+static int cmdCheck(int argc, char** argv) {
+  if (argc < 3) return 2;
+  const char* goldenPath = argv[2];
+  bool update = argc > 3 && std::strcmp(argv[3], "--update") == 0;
+
+  std::ifstream file(goldenPath);
+  if (!file) {
+    std::fprintf(stderr, "%s: nicht lesbar\n", goldenPath);
+    return 1;
+  }
+  // Trace- und Bank-Dateien relativ zur Golden-Datei
+  std::string dir = goldenPath;
+  dir = dir.find('/') == std::string::npos ? "" : dir.substr(0, dir.rfind('/') + 1);
+
+  std::vector<std::string> lines;
+  std::string line;
+  int failures = 0;
+  std::printf("%-20s %6s %9s %9s %9s %9s %11s %11s  %s\n", "case", "reakt", "p50 soll", "p50 ist", "max soll", "max ist",
+              "tasks soll", "tasks ist", "");
+
+  while (std::getline(file, line)) {
+    ReplayCase c;
+    if (line.empty() || line[0] == '#' || !parseCaseLine(line, c)) {
+      lines.push_back(line);
+      continue;
+    }
+
+    Trace trace;
+    if (!loadTrace(dir + c.trace, trace) || !mountBank(c.bank == "-" ? c.bank : dir + c.bank)) return 1;
+    simulate(trace);
+    Summary s = summarize();
+
+    bool worse;
+    const char* status = compareCase(c, s, worse);
+    if (update && std::strcmp(status, "ok") != 0) status = "updated";
+    else if (worse) failures++;
+
+    const TaskCounts& e = c.tasks;
+    const TaskCounts& a = s.tasks;
+    char expectedTasks[48], actualTasks[48];
+    std::snprintf(expectedTasks, sizeof(expectedTasks), "%u/%u/%u/%u", e.creates, e.deletes, e.suspends, e.resumes);
+    std::snprintf(actualTasks, sizeof(actualTasks), "%u/%u/%u/%u", a.creates, a.deletes, a.suspends, a.resumes);
+    std::printf("%-20s %6zu %9.3f %9.3f %9.3f %9.3f %11s %11s  %s\n", c.name.c_str(), s.reactions, c.p50Us / 1000.0,
+                s.p50Us / 1000.0, c.maxUs / 1000.0, s.maxUs / 1000.0, expectedTasks, actualTasks, status);
+
+    char updated[512];
+    std::snprintf(updated, sizeof(updated), "%-20s %-34s %-16s %4zu %8.3f %8.3f %3u %3u %3u %3u", c.name.c_str(),
+                  c.trace.c_str(), c.bank.c_str(), s.reactions, s.p50Us / 1000.0, s.maxUs / 1000.0, a.creates,
+                  a.deletes, a.suspends, a.resumes);
+    lines.push_back(update ? std::string(updated) : line);
+  }
+
+  if (update) {
+    std::ofstream out(goldenPath);
+    for (const auto& l : lines) out << l << "\n";
+  }
+  return failures > 0 ? 1 : 0;
+}
+
+int main(int argc, char** argv) {
+  initSynth();
+
+  int result = 2;
+  if (argc > 1) {
+    if (std::strcmp(argv[1], "run") == 0)   result = cmdRun(argc, argv);
+    if (std::strcmp(argv[1], "check") == 0) result = cmdCheck(argc, argv);
+  }
+  if (result == 2) {
+    std::fprintf(stderr,
+                 "run <trace> [--bank bank.bin] [--edges]\n"
+                 "check <golden.txt> [--update]\n");
+  }
+  return result;
+}
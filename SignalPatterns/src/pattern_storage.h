@@ -0,0 +1,84 @@
+#pragma once
+
+#include <atomic>
+#include <initializer_list>
+#include <stddef.h>
+#include <stdint.h>
+
+// --------------------------------------
+// Feste Speicher für Muster-Daten (ohne Heap)
+// --------------------------------------
+// Tracks, Gates und Hupen-Pattern werden über Tage immer wieder neu geladen. Statt bei jedem
+// Laden Vektoren anzulegen und freizugeben (→ fragmentierter Heap), liegen sie in Listen fester
+// Kapazität und in festen Slot-Pools; Neuladen setzt nur Zähler zurück.
+
+// Liste mit fester Kapazität N, Schnittstelle wie ein kleiner std::vector. Die Einträge liegen
+// direkt im Objekt; push_back() über die Kapazität hinaus verwirft den Eintrag und liefert false.
+template <typename T, size_t N>
+struct FixedList {
+  FixedList() : count(0) {}
+  FixedList(std::initializer_list<T> init) : count(0) {
+    for (const T& item : init) push_back(item);
+  }
+
+  bool push_back(const T& item) {
+    if (count >= N) return false;
+    items[count++] = item;
+    return true;
+  }
+  void pop_back()           { if (count > 0) --count; }
+  void clear()              { count = 0; }
+  void resize(size_t n)     { count = (uint32_t)(n < N ? n : N); }   // neue Einträge bleiben unbestimmt
+
+  size_t size()     const   { return count; }
+  bool   empty()    const   { return count == 0; }
+  bool   full()     const   { return count == N; }
+  static constexpr size_t capacity() { return N; }
+
+  T&       operator[](size_t i)       { return items[i]; }
+  const T& operator[](size_t i) const { return items[i]; }
+  T&       back()                     { return items[count - 1]; }
+  const T& back()               const { return items[count - 1]; }
+
+  T*       data()                     { return items; }
+  const T* data()               const { return items; }
+  T*       begin()                    { return items; }
+  T*       end()                      { return items + count; }
+  const T* begin()              const { return items; }
+  const T* end()                const { return items + count; }
+
+ private:
+  uint32_t count;
+  T        items[N];
+};
+
+// N feste Slots vom Typ T. acquire() liefert einen freien Slot (nullptr, wenn alle belegt sind),
+// release() gibt ihn zurück; Zeiger außerhalb des Pools (z. B. statische Vorgaben) werden
+// ignoriert. Belegen und Freigeben ist lock-frei und darf aus verschiedenen Tasks erfolgen.
+template <typename T, size_t N>
+struct SlotPool {
+  T* acquire() {
+    for (size_t i = 0; i < N; ++i) {
+      bool expected = false;
+      if (used[i].compare_exchange_strong(expected, true, std::memory_order_acq_rel)) return &slots[i];
+    }
+    return nullptr;
+  }
+
+  void release(T* slot) {
+    if (!owns(slot)) return;
+    used[slot - slots].store(false, std::memory_order_release);
+  }
+
+  bool owns(const T* slot) const { return slot >= slots && slot < slots + N; }
+
+  size_t inUse() const {
+    size_t n = 0;
+    for (size_t i = 0; i < N; ++i) n += used[i].load(std::memory_order_relaxed) ? 1 : 0;
+    return n;
+  }
+
+ private:
+  T                 slots[N];
+  std::atomic<bool> used[N] = {};
+};
@@ -0,0 +1,130 @@
+#include <LittleFS.h>
+
+#include "persistence.h"
+#include "track_format.h"
+
+// --------------------
+// Zustand
+// --------------------
+// Neuester Stand je Datei in festen Puffern (kein Heap pro Speichern), geschützt durch persistMutex
+static uint8_t tracksData[TRACKS_BINARY_MAX_SIZE];
+static uint8_t honkPatternData[PERSIST_TEXT_MAX_SIZE];
+static uint8_t morseMessageData[PERSIST_TEXT_MAX_SIZE];
+static uint8_t bootSnapshotData[BOOT_SNAPSHOT_MAX_SIZE];
+
+struct PersistEntry {
+  const char* path;
+  uint8_t*    data;
+  size_t      capacity;
+  size_t      len;
+  bool        dirty;
+  bool        written;      // writtenCrc gilt (Datei entspricht dem Stand)
+  uint32_t    writtenCrc;   // nur Writer-Task
+};
+
+static PersistEntry persistEntries[(size_t)PersistFile::COUNT] = {
+  { TRACKS_FILE,        tracksData,       sizeof(tracksData),       0, false, false, 0 },
+  { HONK_PATTERN_FILE,  honkPatternData,  sizeof(honkPatternData),  0, false, false, 0 },
+  { MORSE_MESSAGE_FILE, morseMessageData, sizeof(morseMessageData), 0, false, false, 0 },
+  { BOOT_SNAPSHOT_FILE, bootSnapshotData, sizeof(bootSnapshotData), 0, false, false, 0 },
+};
+
+static SemaphoreHandle_t persistMutex = NULL;
+TaskHandle_t persistTaskHandle = NULL;
+
+// --------------------
+// Producer-Seite (Web-Handler, setup)
+// --------------------
+void startPersistence() {
+  if (persistTaskHandle != NULL) return;
+
+  persistMutex = xSemaphoreCreateMutex();
+
+  // Core 0 und Priorität unter async_tcp: Flash-Zugriffe verzögern weder Web-Server noch Audio-Task
+  xTaskCreatePinnedToCore(persistenceTask, PERSIST_TASK, PERSIST_TASK_STACK, NULL, tskIDLE_PRIORITY + 1, &persistTaskHandle, 0);
+}
+
+bool persistLater(PersistFile file, const uint8_t* data, size_t len) {
+  PersistEntry& entry = persistEntries[(size_t)file];
+  if (persistTaskHandle == NULL || len > entry.capacity) return false;
+
+  xSemaphoreTake(persistMutex, portMAX_DELAY);
+  memcpy(entry.data, data, len);
+  entry.len   = len;
+  entry.dirty = true;
+  xSemaphoreGive(persistMutex);
+
+  xTaskNotifyGive(persistTaskHandle);
+  return true;
+}
+
+void persistLoaded(PersistFile file, const uint8_t* data, size_t len) {
+  PersistEntry& entry = persistEntries[(size_t)file];
+  entry.written    = true;
+  entry.writtenCrc = crc32(data, len);
+}
+
+// --------------------
+// Writer-Task
+// --------------------
+static bool writeFileAtomically(const char* path, const uint8_t* data, size_t len) {
+  char tmpPath[40];
+  snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", path);
+
+  File f = LittleFS.open(tmpPath, "w");
+  if (!f) return false;
+  size_t written = f.write(data, len);
+  f.close();
+  if (written != len) {
+    LittleFS.remove(tmpPath);
+    return false;
+  }
+
+  // LittleFS ersetzt ein vorhandenes Ziel; scheitert rename, bleibt die alte Datei stehen und der
+  // Writer versucht es später erneut
+  return LittleFS.rename(tmpPath, path);
+}
+
+void persistenceTask(void* parameter) {
+  static uint8_t buffer[PERSIST_MAX_SIZE];
+
+  bool retry = false;   // ein Schreiben ist fehlgeschlagen: ohne neue Änderung nach PERSIST_RETRY_MS erneut
+  while (true) {
+    if (ulTaskNotifyTake(pdTRUE, retry ? pdMS_TO_TICKS(PERSIST_RETRY_MS) : portMAX_DELAY) > 0) {
+      // Ruhephase: jede weitere Änderung verlängert das Fenster, bis PERSIST_MAX_DELAY_MS erreicht ist
+      TickType_t firstChange = xTaskGetTickCount();
+      while (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(PERSIST_QUIET_MS)) > 0) {
+        if (xTaskGetTickCount() - firstChange >= pdMS_TO_TICKS(PERSIST_MAX_DELAY_MS)) break;
+      }
+    }
+    retry = false;
+
+    for (PersistEntry& entry : persistEntries) {
+      xSemaphoreTake(persistMutex, portMAX_DELAY);
+      bool   dirty = entry.dirty;
+      size_t len   = entry.len;
+      if (dirty) memcpy(buffer, entry.data, len);
+      entry.dirty = false;
+      xSemaphoreGive(persistMutex);
+
+      if (!dirty) continue;
+
+      uint32_t crc = crc32(buffer, len);
+      if (entry.written && entry.writtenCrc == crc) continue;   // unverändert (z. B. Drag zurück auf Ausgang)
+
+      if (writeFileAtomically(entry.path, buffer, len)) {
+        entry.written    = true;
+        entry.writtenCrc = crc;
+      } else {
+        // Derselbe Stand noch einmal, sofern bis dahin kein neuerer kommt
+        entry.written = false;
+        xSemaphoreTake(persistMutex, portMAX_DELAY);
+        entry.dirty = true;
+        xSemaphoreGive(persistMutex);
+        retry = true;
+        Serial.print("Fehler: konnte nicht speichern: ");
+        Serial.println(entry.path);
+      }
+    }
+  }
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "boot_snapshot.h"
+#include "track_format.h"
+
+// --------------------------------------
+// Persistenz-Queue (LittleFS)
+// --------------------------------------
+// Web-Handler schreiben nie selbst in den Flash: persistLater() legt nur den neuesten Stand einer
+// Datei im RAM ab. Der Writer-Task (Core 0, niedrige Priorität) wartet, bis PERSIST_QUIET_MS lang
+// keine Änderung mehr kam (höchstens PERSIST_MAX_DELAY_MS), und schreibt dann je Datei nur den
+// letzten Stand: erst <pfad>.tmp, dann rename – ein Stromausfall hinterlässt nie eine halbe Datei.
+// Scheitert ein Schreiben, bleibt die alte Datei unangetastet und der Writer versucht es erneut.
+// Inhalte, die schon so im Flash liegen (CRC-Vergleich), werden nicht erneut geschrieben.
+
+// BOOT_SNAPSHOT zuletzt: der Writer geht die Dateien in dieser Reihenfolge durch, der Snapshot ist
+// so nie älter als die Einzeldateien
+enum class PersistFile : uint8_t { TRACKS, HONK_PATTERN, MORSE_MESSAGE, BOOT_SNAPSHOT, COUNT };
+
+constexpr const char* TRACKS_FILE        = "/tracks.bin";        // Nutzer-Tracks im Binärformat (track_format.h)
+constexpr const char* HONK_PATTERN_FILE  = "/pattern.json";      // {"first":"HIGH","patternChanges":[...]}
+constexpr const char* MORSE_MESSAGE_FILE = "/morseMessage.txt";
+constexpr const char* CONFIG_FILE        = "/config/config.json"; // nur gelesen (uploadfs), Rückfall ohne Snapshot
+constexpr const char* BOOT_SNAPSHOT_FILE = "/boot.bin";          // alles für den Boot in einer Datei (boot_snapshot.h)
+
+constexpr uint32_t PERSIST_QUIET_MS      = 1000;   // Ruhephase vor dem Schreiben
+constexpr uint32_t PERSIST_MAX_DELAY_MS  = 10000;  // spätestens dann wird auch bei Dauer-Änderungen geschrieben
+constexpr uint32_t PERSIST_RETRY_MS      = 5000;   // nach einem fehlgeschlagenen Schreiben
+constexpr size_t   PERSIST_TEXT_MAX_SIZE = 4096;    // pattern.json, morseMessage.txt (Bytes)
+constexpr size_t   PERSIST_MAX_SIZE      = BOOT_SNAPSHOT_MAX_SIZE > PERSIST_TEXT_MAX_SIZE ? BOOT_SNAPSHOT_MAX_SIZE : PERSIST_TEXT_MAX_SIZE;   // größte Datei (Bytes); boot.bin wächst mit TRACK_COUNT
+
+constexpr const char* PERSIST_TASK       = "Persist-Task";
+constexpr uint32_t    PERSIST_TASK_STACK = 4096;   // Bytes
+
+extern TaskHandle_t persistTaskHandle;
+
+void startPersistence();
+bool persistLater(PersistFile file, const uint8_t* data, size_t len);   // false: zu groß / nicht gestartet
+void persistLoaded(PersistFile file, const uint8_t* data, size_t len);  // beim Booten gelesener Stand, vor startPersistence()
+void persistenceTask(void* parameter);
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// --------------------------------------
+// Plattform-Schicht für die Synth-Engine
+// --------------------------------------
+// esp32dev: platform_esp32.cpp (DAC + esp_timer + Serial + Flash-Partitionen)
+// native:   native/platform_native.cpp (Host-Uhr, Ausgabe verworfen, Dateien per mmap)
+
+// Schreibt ein 8-Bit-Sample auf beide DAC-Kanäle
+void platformDacWrite(uint8_t value);
+
+// Monotone Zeit in Mikrosekunden
+int64_t platformMicros();
+
+// Einzeilige Log-Ausgabe (ohne Zeilenumbruch am Ende übergeben)
+void platformLog(const char* message);
+
+// Ein Producer hat Satz, Quelle oder Gate geändert; weckt einen in der Stille schlafenden Audio-Pfad
+void platformAudioChanged();
+
+// Bildet einen read-only Datenbereich ohne Kopie in den Adressraum ab und lässt ihn bis zum Ende
+// gemappt: esp32dev die Datenpartition mit Label name (Flash-MMU), native die Datei name (mmap).
+// nullptr, wenn es ihn nicht gibt; size ist dann 0.
+const uint8_t* platformMapReadOnly(const char* name, size_t& size);
@@ -0,0 +1,39 @@
+#include <Arduino.h>
+#include <driver/dac.h>
+#include <esp_partition.h>
+#include <esp_timer.h>
+
+#include "main.h"
+#include "platform.h"
+
+void platformDacWrite(uint8_t value) {
+  dac_output_voltage(DAC_CHANNEL_1, value);
+  dac_output_voltage(DAC_CHANNEL_2, value);
+}
+
+int64_t platformMicros() {
+  return esp_timer_get_time();
+}
+
+void platformLog(const char* message) {
+  Serial.println(message);
+}
+
+void platformAudioChanged() {
+  TaskHandle_t task = dacTaskHandle;
+  if (task != NULL) xTaskNotifyGive(task);
+}
+
+const uint8_t* platformMapReadOnly(const char* name, size_t& size) {
+  size = 0;
+  const esp_partition_t* partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, name);
+  if (partition == nullptr) return nullptr;
+
+  // Über den Daten-Cache gelesen; während eines Flash-Schreibvorgangs (LittleFS) steht der Audio-Pfad
+  // ohnehin, weil auch sein Code im Flash liegt
+  const void*             mapped = nullptr;
+  spi_flash_mmap_handle_t handle;
+  if (esp_partition_mmap(partition, 0, partition->size, SPI_FLASH_MMAP_DATA, &mapped, &handle) != ESP_OK) return nullptr;
+  size = partition->size;
+  return (const uint8_t*)mapped;
+}
@@ -0,0 +1,122 @@
+#include <string.h>
+#include <type_traits>
+
+#include "preset_bank.h"
+#include "track_format.h"
+
+// Die Sätze werden ohne Kopie als TrackSet gelesen
+static_assert(std::is_trivially_copyable<TrackSet>::value && std::is_standard_layout<TrackSegments>::value,
+              "TrackSet muss direkt aus dem Bild lesbar sein");
+static_assert(sizeof(TrackSegments) == 4 + MAX_SEGMENTS_PER_TRACK * sizeof(TrackSegment),
+              "TrackSegments: uint32 Anzahl + Segmente ohne Padding");
+static_assert((PRESET_BANK_HEADER + PRESET_NAME_SIZE) % alignof(TrackSet) == 0,
+              "Sätze müssen im Bild ausgerichtet liegen");
+
+// Eingebundene Bank; wird nur beim Booten gesetzt
+static const char*     bankNames = nullptr;
+static const TrackSet* bankSets  = nullptr;
+static size_t          bankCount = 0;
+
+static inline uint16_t getU16(const uint8_t* p) { uint16_t v; memcpy(&v, p, 2); return v; }
+static inline uint32_t getU32(const uint8_t* p) { uint32_t v; memcpy(&v, p, 4); return v; }
+static inline void     putU16(uint8_t* p, uint16_t v) { memcpy(p, &v, 2); }
+static inline void     putU32(uint8_t* p, uint32_t v) { memcpy(p, &v, 4); }
+
+// Alles, worauf sich der Audio-Pfad verlässt: Kapazität, gültige Enums, Präfixsummen
+static bool validSet(const TrackSet& set) {
+  for (const auto& track : set) {
+    if (track.size() > TrackSegments::capacity()) return false;
+    uint32_t endMs = 0;
+    for (const TrackSegment& seg : track) {
+      endMs += seg.duration;
+      if ((uint8_t)seg.waveForm > (uint8_t)WaveForm::WF_TRI || (uint8_t)seg.transition > (uint8_t)Transition::TR_NONE
+          || seg.endMs != endMs || !(seg.freq >= 0.0f)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// Nullterminiert, druckbares ASCII ohne " und \ (wird so in JSON ausgegeben)
+static bool validName(const char* name) {
+  if (name[0] == '\0' || name[PRESET_NAME_SIZE - 1] != '\0') return false;
+  for (const char* c = name; *c != '\0'; ++c) {
+    if (*c < 0x20 || *c > 0x7E || *c == '"' || *c == '\\') return false;
+  }
+  return true;
+}
+
+bool mountPresetBank(const uint8_t* image, size_t size) {
+  bankNames = nullptr;
+  bankSets  = nullptr;
+  bankCount = 0;
+
+  if (image == nullptr || size < PRESET_BANK_HEADER) return false;
+  if (memcmp(image, PRESET_BANK_MAGIC, 4) != 0 || image[4] != PRESET_BANK_VERSION) return false;
+  if (image[5] != TRACK_COUNT || getU32(image + 8) != sizeof(TrackSet)) return false;
+  if ((uintptr_t)image % alignof(TrackSet) != 0) return false;
+
+  const size_t count = getU16(image + 6);
+  const size_t used  = presetBankSize(count);
+  if (used > size) return false;
+  if (getU32(image + 12) != crc32(image + PRESET_BANK_HEADER, used - PRESET_BANK_HEADER)) return false;
+
+  const char*     names = (const char*)(image + PRESET_BANK_HEADER);
+  const TrackSet* sets  = reinterpret_cast<const TrackSet*>(image + PRESET_BANK_HEADER + count * PRESET_NAME_SIZE);
+  for (size_t i = 0; i < count; ++i) {
+    if (!validName(names + i * PRESET_NAME_SIZE) || !validSet(sets[i])) return false;
+  }
+
+  bankNames = names;
+  bankSets  = sets;
+  bankCount = count;
+  return true;
+}
+
+size_t presetCount() {
+  return bankCount;
+}
+
+const char* presetName(size_t index) {
+  return index < bankCount ? bankNames + index * PRESET_NAME_SIZE : nullptr;
+}
+
+const TrackSet* presetTracks(size_t index) {
+  return index < bankCount ? &bankSets[index] : nullptr;
+}
+
+int findPreset(const char* name) {
+  for (size_t i = 0; i < bankCount; ++i) {
+    if (strncmp(presetName(i), name, PRESET_NAME_SIZE) == 0) return (int)i;
+  }
+  return -1;
+}
+
+size_t encodePresetBank(const TrackSet* const* sets, const char* const* names, size_t count, uint8_t* out, size_t capacity) {
+  const size_t size = presetBankSize(count);
+  if (count > UINT16_MAX || size > capacity || (uintptr_t)out % alignof(TrackSet) != 0) return 0;
+
+  memset(out, 0, size);
+  memcpy(out, PRESET_BANK_MAGIC, 4);
+  out[4] = PRESET_BANK_VERSION;
+  out[5] = TRACK_COUNT;
+  putU16(out + 6, (uint16_t)count);
+  putU32(out + 8, sizeof(TrackSet));
+
+  char*     outNames = (char*)(out + PRESET_BANK_HEADER);
+  TrackSet* outSets  = reinterpret_cast<TrackSet*>(out + PRESET_BANK_HEADER + count * PRESET_NAME_SIZE);
+  for (size_t i = 0; i < count; ++i) {
+    strncpy(outNames + i * PRESET_NAME_SIZE, names[i], PRESET_NAME_SIZE - 1);
+    // Über die Schnittstelle von FixedList in den genullten Speicher, damit unbenutzte Segmente 0 bleiben
+    TrackSet& set = outSets[i];
+    for (size_t t = 0; t < set.size(); ++t) {
+      set[t].clear();
+      for (const TrackSegment& seg : (*sets[i])[t]) set[t].push_back(seg);
+    }
+    compileTimeline(set);
+  }
+
+  putU32(out + 12, crc32(out + PRESET_BANK_HEADER, size - PRESET_BANK_HEADER));
+  return size;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "synth.h"
+
+// --------------------------------------
+// Preset-Bank (read-only, direkt aus dem Flash)
+// --------------------------------------
+// Ein Bild mit vielen fertigen Track-Sätzen in einer eigenen Datenpartition. Es wird nur in den
+// Adressraum abgebildet (platformMapReadOnly(): Flash-MMU bzw. mmap auf dem Host), nie kopiert
+// oder geparst: Die Sätze liegen im Speicherlayout der Engine (TrackSet, Timeline schon
+// kompiliert), der Audio-Pfad spielt direkt aus dem Mapping. Umschalten ist ein Zeiger
+// (presetTracks(i) → selectPreset()), unabhängig von Anzahl und Größe der Presets.
+//
+// Little Endian:
+//    0  char[4]   "SPPB"
+//    4  uint8     Version (PRESET_BANK_VERSION)
+//    5  uint8     TRACK_COUNT des Schreibers
+//    6  uint16    Anzahl Presets n
+//    8  uint32    Größe eines Satzes (sizeof(TrackSet) des Schreibers)
+//   12  uint32    CRC32 über alle folgenden Bytes bis zum Ende des letzten Satzes
+//   16  char[n][PRESET_NAME_SIZE]   Namen, nullterminiert
+//   16+24n        n × TrackSet (je Track uint32 Anzahl + MAX_SEGMENTS_PER_TRACK × TrackSegment,
+//                 unbenutzte Segmente 0)
+//
+// Das Layout hängt an TRACK_COUNT und MAX_SEGMENTS_PER_TRACK; ein Bild mit anderen Werten wird
+// nicht eingebunden. Erzeugt wird es auf dem Host (native_render, Befehl "bank").
+
+constexpr uint8_t     PRESET_BANK_MAGIC[4]  = { 'S', 'P', 'P', 'B' };
+constexpr uint8_t     PRESET_BANK_VERSION   = 1;
+constexpr size_t      PRESET_BANK_HEADER    = 16;
+constexpr size_t      PRESET_NAME_SIZE      = 24;
+constexpr const char* PRESET_BANK_PARTITION = "presets";   // Label der Datenpartition (partitions.csv)
+
+constexpr size_t presetBankSize(size_t count) { return PRESET_BANK_HEADER + count * (PRESET_NAME_SIZE + sizeof(TrackSet)); }
+
+// Prüft Kopf, CRC und jeden Satz (Segmentzahl, Wellenform, Timeline) einmal; danach vertraut der
+// Audio-Pfad dem Bild. Das Mapping muss so lange bestehen bleiben, wie ein Preset spielen kann.
+bool mountPresetBank(const uint8_t* image, size_t size);
+
+size_t          presetCount();                    // 0 ohne eingebundene Bank
+const char*     presetName(size_t index);         // nullptr außerhalb
+const TrackSet* presetTracks(size_t index);       // nullptr außerhalb
+int             findPreset(const char* name);     // -1: unbekannt
+
+// Schreibt ein Bild aus count Sätzen (Timeline wird dabei kompiliert); 0 bei zu kleinem oder nicht
+// auf TrackSet ausgerichtetem Puffer. Namen werden auf PRESET_NAME_SIZE - 1 Zeichen gekürzt; erlaubt
+// sind druckbare ASCII-Zeichen ohne " und \, sonst verweigert mountPresetBank() das Bild.
+size_t encodePresetBank(const TrackSet* const* sets, const char* const* names, size_t count, uint8_t* out, size_t capacity);
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// --------------------------------------
+// Lock-freier SPSC-Ringpuffer für Samples
+// --------------------------------------
+// Genau ein Producer (Render-Task, write) und ein Consumer (Timer-ISR, pop). head/tail laufen frei
+// über; N muss eine Zweierpotenz sein. Alles ist erzwungen inline, damit pop() im IRAM-ISR keinen
+// Aufruf in den Flash erzeugt.
+
+#define SAMPLE_RING_INLINE inline __attribute__((always_inline))
+
+template <size_t N>
+struct SampleRing {
+  static_assert(N > 0 && (N & (N - 1)) == 0, "SampleRing: N muss eine Zweierpotenz sein");
+
+  SAMPLE_RING_INLINE uint32_t available() const {
+    return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+  }
+
+  SAMPLE_RING_INLINE uint32_t space() const {
+    return (uint32_t)N - available();
+  }
+
+  // Producer: schreibt höchstens space() Samples, liefert die geschriebene Anzahl
+  SAMPLE_RING_INLINE size_t write(const uint8_t* data, size_t count) {
+    uint32_t h    = head.load(std::memory_order_relaxed);
+    uint32_t free = (uint32_t)N - (h - tail.load(std::memory_order_acquire));
+    if (count > free) count = free;
+
+    size_t start = h & (N - 1);
+    size_t first = count < N - start ? count : N - start;
+    memcpy(buffer + start, data, first);
+    memcpy(buffer, data + first, count - first);
+
+    head.store(h + (uint32_t)count, std::memory_order_release);
+    return count;
+  }
+
+  // Consumer: false, wenn leer (Underrun)
+  SAMPLE_RING_INLINE bool pop(uint8_t& sample) {
+    uint32_t t = tail.load(std::memory_order_relaxed);
+    if (head.load(std::memory_order_acquire) == t) return false;
+
+    sample = buffer[t & (N - 1)];
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Nur wenn weder Producer noch Consumer laufen
+  void reset() {
+    head.store(0, std::memory_order_relaxed);
+    tail.store(0, std::memory_order_relaxed);
+  }
+
+  std::atomic<uint32_t> head{0};
+  std::atomic<uint32_t> tail{0};
+  uint8_t               buffer[N];
+};
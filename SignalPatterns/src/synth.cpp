@@ -0,0 +1,1016 @@
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "synth.h"
+#include "platform.h"
+
+// --------------------
+// Globale Variablen
+// --------------------
+TrackSet tracks = {
+  TrackSegments{ TrackSegment{440.0f, 750, WaveForm::WF_SQUARE, Transition::TR_NONE}, TrackSegment{587.33f, 750, WaveForm::WF_SQUARE, Transition::TR_NONE} },
+  TrackSegments{ TrackSegment{440.0f, 750, WaveForm::WF_SQUARE, Transition::TR_NONE}, TrackSegment{587.33f, 750, WaveForm::WF_SQUARE, Transition::TR_NONE} },
+  TrackSegments{ TrackSegment{441.0f, 750, WaveForm::WF_SQUARE, Transition::TR_NONE}, TrackSegment{586.33f, 750, WaveForm::WF_SQUARE, Transition::TR_NONE} },
+  TrackSegments{ TrackSegment{441.0f, 750, WaveForm::WF_SQUARE, Transition::TR_NONE}, TrackSegment{586.33f, 750, WaveForm::WF_SQUARE, Transition::TR_NONE} }
+};
+TrackSet synthHorn = {
+  TrackSegments{ TrackSegment{335.0f, 10000, WaveForm::WF_SQUARE, Transition::TR_NONE} },
+  TrackSegments{ TrackSegment{335.0f, 10000, WaveForm::WF_SQUARE, Transition::TR_NONE} },
+  TrackSegments{ TrackSegment{335.0f, 10000, WaveForm::WF_SQUARE, Transition::TR_NONE} },
+  TrackSegments{ TrackSegment{335.0f, 10000, WaveForm::WF_SQUARE, Transition::TR_NONE} }
+};
+
+const TrackSet* activeTracks = &synthHorn;
+TrackSet*       userTracks   = &tracks;
+
+// Feste Slots für hochgeladene Sätze und Gates; tracks, synthHorn und openGate liegen außerhalb
+static SlotPool<TrackSet, TRACK_SET_POOL_SIZE> trackSetPool;
+static SlotPool<GatePattern, GATE_POOL_SIZE>   gatePool;
+
+std::atomic<TrackSet*>   pendingTracks{nullptr};
+std::atomic<TrackSet*>   retiredTracks{nullptr};
+std::atomic<TrackSource> requestedSource{TrackSource::HORN};
+std::atomic<const TrackSet*> requestedPreset{nullptr};
+
+// Zuletzt übernommene Quelle und Preset (nur Audio-Pfad)
+static TrackSource     playingSource = TrackSource::HORN;
+static const TrackSet* playingPreset = nullptr;
+
+std::atomic<GatePattern*> pendingGate{nullptr};
+std::atomic<GatePattern*> retiredGate{nullptr};
+
+// Live-Patches (SPSC-Ring): Producer schreibt patchHead, der Audio-Pfad patchTail; beide laufen frei über
+static SegmentPatch          patchQueue[PATCH_QUEUE_SIZE];
+static std::atomic<uint32_t> patchHead{0};
+static std::atomic<uint32_t> patchTail{0};
+// Erster Patch nach dem zuletzt veröffentlichten Satz; ältere stecken schon im Upload und würden ihn
+// sonst mit überholten Werten überschreiben
+static std::atomic<uint32_t> patchValidFrom{0};
+static_assert((PATCH_QUEUE_SIZE & (PATCH_QUEUE_SIZE - 1)) == 0, "PATCH_QUEUE_SIZE muss eine Zweierpotenz sein");
+
+// Verschiebung der Wiedergabe in ms, übernommen am nächsten Blockanfang; 0 = keine
+static std::atomic<uint32_t> pendingAdvanceMs{0};
+
+// Gate-Zustand (nur Audio-Pfad); openGate steht für "kein Gate" und wird nie freigegeben
+static GatePattern  openGate     = { true, {} };
+static GatePattern* activeGate   = &openGate;
+static size_t       gateRun      = 0;
+static uint32_t     gateRunLeft  = 0;
+static bool         gateOpen     = true;
+static float        gateGain        = 1.0f;
+static float        gateRampStep    = 1.0f;
+static int32_t      gateGainQ15     = Q15_ONE;   // Rampe im FIXED-Pfad
+static int32_t      gateRampStepQ15 = Q15_ONE;
+
+VoiceState voices                  = {};
+
+uint32_t  sampleRate               = SAMPLE_RATE;
+static float phaseStepPerHz        = 4294967296.0f / (float)SAMPLE_RATE;
+
+uint32_t  linearFadeSamples        = 1;
+float     invLinearFadeSamples     = 1.0f;
+float     expAlpha                 = 0.0f;
+uint32_t  expFadeSamples           = 1;
+
+// Konstanten des FIXED-Pfads, setzt setSampleRate()
+static uint32_t linearFadeQ24      = 1u << 24;   // 1 / linearFadeSamples in Q24
+static uint32_t expDecayQ31        = 0;          // 1 - expAlpha in Q31
+constexpr uint32_t EXP_LEFT_START_Q31 = (uint32_t)((1.0 - EXP_FADE_START) * 2147483648.0);
+
+static RenderMode currentMode = SYNTH_FIXED_POINT ? RenderMode::FIXED : RenderMode::FLOAT;
+static bool       ditherOn    = SYNTH_DITHER;
+
+// TPDF-Dither: xorshift32, beginnt bei jedem seekTracks() neu (reproduzierbare Renders)
+constexpr uint32_t DITHER_SEED = 0x9E3779B9u;
+static uint32_t    ditherState = DITHER_SEED;
+
+// Eine Sinusperiode + Wiederholung des ersten Werts für die Interpolation
+static float   sineTable[SINE_TABLE_SIZE + 1];
+static int16_t sineTableQ15[SINE_TABLE_SIZE + 1];
+
+static inline uint32_t msToSamples(uint32_t ms) {
+  // Mindestens 1 Sample, um 0-Dauern zu vermeiden
+  uint32_t s = (uint32_t)((uint64_t)ms * sampleRate / 1000ULL);
+  return s == 0 ? 1u : s;
+}
+
+// Zeitpunkt ms ab Schleifen- bzw. Musterbeginn als Sample-Offset. Grenzen werden aus der
+// aufsummierten Zeit gerundet, damit sich Rundungsfehler über viele Abschnitte nicht aufaddieren.
+static inline uint32_t msToSampleOffset(uint32_t ms) {
+  return (uint32_t)(((uint64_t)ms * sampleRate + 500) / 1000);
+}
+
+static inline void updatePhaseStep(int v, float freq) {
+  // Phaseninkrement = freq / sampleRate * 2^32; auf 0..Nyquist begrenzt, damit der Cast definiert bleibt
+  if (freq < 0.0f) freq = 0.0f;
+  if (freq > sampleRate / 2) freq = sampleRate / 2;
+  voices.step[v] = (uint32_t)(freq * phaseStepPerHz);
+}
+
+static inline bool gateRunIsOpen(const GatePattern& gate, size_t run) {
+  return ((run % 2) == 0) == gate.startsOpen;
+}
+
+// Länge von Abschnitt run in Samples; jeder Abschnitt dauert mindestens ein Sample
+static inline uint32_t gateRunSamples(const GatePattern& gate, size_t run) {
+  uint32_t end   = msToSampleOffset(gate.endsMs[run]);
+  uint32_t begin = run == 0 ? 0 : msToSampleOffset(gate.endsMs[run - 1]);
+  return end > begin ? end - begin : 1u;
+}
+
+// Schleifenlänge des gespielten Satzes in Samples (längster Track); setzt seekTracks()
+static uint32_t loopSamples = 0;
+
+// Ein Track kürzer als die Schleife schweigt bis zu ihrem Ende: Segment track.size() ist diese
+// Stille, ohne dass sie im Satz gespeichert wird
+static const TrackSegment SILENT_TAIL = { 0.0f, 0, WaveForm::WF_SQUARE, Transition::TR_NONE, 0 };
+
+// Segmentgrenzen eines Tracks in Samples (aus TrackSegment::endMs); 0-lange Segmente sind möglich
+static inline uint32_t segStartSample(const TrackSegments& track, size_t seg) {
+  return seg == 0 ? 0 : msToSampleOffset(track[seg - 1].endMs);
+}
+static inline uint32_t segEndSample(const TrackSegments& track, size_t seg) {
+  return seg < track.size() ? msToSampleOffset(track[seg].endMs) : loopSamples;
+}
+
+float generateWave(WaveForm waveForm, uint32_t phase) {
+  // Liefert -1..+1; Phase 0..2^32 entspricht 0..2pi
+  switch (waveForm) {
+    case WaveForm::WF_SINE: {
+      // Obere Bits: Tabellenindex, Rest: Interpolationsanteil
+      uint32_t idx  = phase >> (32 - SINE_TABLE_BITS);
+      float    frac = (float)(phase << SINE_TABLE_BITS) * (1.0f / 4294967296.0f);
+      float    a    = sineTable[idx];
+      return a + (sineTable[idx + 1] - a) * frac;
+    }
+    case WaveForm::WF_SQUARE:
+      // Erste Halbperiode (sin >= 0) → +1
+      return (phase & 0x80000000u) ? -1.0f : 1.0f;
+    case WaveForm::WF_SAW:
+      // 0..2^32 -> -1..+1 (ansteigende Säge)
+      return (float)phase * (1.0f / 2147483648.0f) - 1.0f;
+    case WaveForm::WF_TRI: {
+      // |phase - pi| / pi * 2 - 1: startet bei +1, -1 bei pi (phasengleich zur bisherigen Variante)
+      uint32_t dist = (phase >= 0x80000000u) ? phase - 0x80000000u : 0x80000000u - phase;
+      return (float)dist * (1.0f / 1073741824.0f) - 1.0f;
+    }
+    default:
+      return 0.0f;
+  }
+}
+
+int32_t generateWaveQ15(WaveForm waveForm, uint32_t phase) {
+  // Wie generateWave(), ganzzahlig; Sinus-Interpolation mit 16 Bit Anteil
+  switch (waveForm) {
+    case WaveForm::WF_SINE: {
+      uint32_t idx  = phase >> (32 - SINE_TABLE_BITS);
+      int32_t  frac = (int32_t)((phase << SINE_TABLE_BITS) >> 16);
+      int32_t  a    = sineTableQ15[idx];
+      return a + (((sineTableQ15[idx + 1] - a) * frac) >> 16);
+    }
+    case WaveForm::WF_SQUARE:
+      return (phase & 0x80000000u) ? -Q15_ONE : Q15_ONE;
+    case WaveForm::WF_SAW:
+      return (int32_t)(phase >> 16) - Q15_ONE;
+    case WaveForm::WF_TRI: {
+      uint32_t dist = (phase >= 0x80000000u) ? phase - 0x80000000u : 0x80000000u - phase;
+      return (int32_t)(dist >> 15) - Q15_ONE;
+    }
+    default:
+      return 0;
+  }
+}
+
+void initSynth() {
+  for (uint32_t i = 0; i <= SINE_TABLE_SIZE; ++i) {
+    sineTable[i]    = sinf(2.0f * (float)M_PI * (float)i / (float)SINE_TABLE_SIZE);
+    sineTableQ15[i] = (int16_t)lrintf(sineTable[i] * (float)(Q15_ONE - 1));
+  }
+  compileTimeline(tracks);
+  compileTimeline(synthHorn);
+  setSampleRate(chooseSampleRate(*activeTracks));
+}
+
+uint32_t chooseSampleRate(const TrackSet& set) {
+#if ADAPTIVE_SAMPLE_RATE
+  // Höchste relevante Oberwelle über alle Segmente
+  float highest = 0.0f;
+  for (const auto& track : set) {
+    for (const auto& seg : track) {
+      float f = seg.freq * WAVEFORM_HARMONICS[(uint8_t)seg.waveForm & 3];
+      if (f > highest) highest = f;
+    }
+  }
+  for (uint32_t rate : SAMPLE_RATES) {
+    if (highest < rate / 2) return rate;
+  }
+#endif
+  return SAMPLE_RATE;
+}
+
+void setSampleRate(uint32_t rate) {
+  uint32_t previous = sampleRate;
+  sampleRate     = rate;
+  phaseStepPerHz = 4294967296.0f / (float)rate;
+
+  // Fade-Konstanten aus den ms-Vorgaben ableiten
+  linearFadeSamples    = msToSamples(LINEAR_FADE_MS);
+  invLinearFadeSamples = 1.0f / (float)linearFadeSamples;
+  gateRampStep         = 1.0f / (float)msToSamples(GATE_RAMP_MS);
+  expAlpha             = 1.0f - expf(-1.0f / (float)msToSamples(EXP_TAU_MS));
+  // Samples, bis 1 - g unter EXP_FADE_SETTLED fällt: (1 - g0) * (1 - alpha)^n = EXP_FADE_SETTLED
+  expFadeSamples       = (uint32_t)ceilf(logf(EXP_FADE_SETTLED / (1.0f - EXP_FADE_START)) / logf(1.0f - expAlpha));
+
+  linearFadeQ24        = (1u << 24) / linearFadeSamples;
+  expDecayQ31          = (uint32_t)(exp(-1.0 / (double)msToSamples(EXP_TAU_MS)) * 2147483648.0);
+  gateRampStepQ15      = Q15_ONE / (int32_t)msToSamples(GATE_RAMP_MS);
+  if (gateRampStepQ15 < 1) gateRampStepQ15 = 1;
+
+  // Laufender Gate-Abschnitt: Restdauer mitskalieren, die folgenden rechnet applyGate() neu
+  if (gateRunLeft > 0 && previous != rate) {
+    uint32_t left = (uint32_t)((uint64_t)gateRunLeft * rate / previous);
+    gateRunLeft = left > 0 ? left : 1u;
+  }
+}
+
+void compileTimeline(TrackSet& set) {
+  for (auto& track : set) {
+    uint32_t endMs = 0;
+    for (auto& seg : track) {
+      endMs    += seg.duration;
+      seg.endMs = endMs;
+    }
+  }
+}
+
+// --------------------------------------
+// Render-Kernel
+// --------------------------------------
+// Pro WaveForm × Transition eine eigene Schleife; W und T sind Template-Parameter,
+// die switch-Anweisungen in generateWave()/Gain werden dadurch zur Compile-Zeit aufgelöst.
+// Ein Kernel rendert einen Lauf von n Samples einer Stimme additiv in mix[]; gemischt wird
+// stimmenweise über den ganzen Lauf. Die Länge des Laufs begrenzt renderMix() so, dass weder
+// Segment- noch Fade-Ende darin liegen.
+//
+// Phase und linearer Fade hängen nur von i ab (Überlauf der Phase = Wrap um 2pi); ohne
+// Abhängigkeit zwischen den Iterationen kann der Compiler die Schleife vektorisieren. Nur der
+// exp-Fade ist eine Rekursion und bleibt skalar, er läuft aber nur kurz nach dem Segmentbeginn.
+
+template <WaveForm W, Transition T>
+static void renderRun(int v, void* out, uint32_t n) {
+  float* __restrict mix  = static_cast<float*>(out);
+  const uint32_t phase   = voices.phase[v];
+  const uint32_t step    = voices.step[v];
+  const uint32_t elapsed = voices.elapsed[v];
+
+  if (T == Transition::TR_EXP) {
+    const float alpha = expAlpha;
+    float       g     = voices.gain[v];
+    for (uint32_t i = 0; i < n; ++i) {
+      // One-pole Richtung 1.0
+      g += (1.0f - g) * alpha;
+      if (g > 1.0f) g = 1.0f;
+      mix[i] += generateWave(W, phase + step * i) * g;
+    }
+    voices.gain[v] = g;
+  } else {
+    const float invFade = invLinearFadeSamples;
+    for (uint32_t i = 0; i < n; ++i) {
+      float s = generateWave(W, phase + step * i);
+      if (T == Transition::TR_LINEAR) s *= (float)(elapsed + i) * invFade;
+      mix[i] += s;
+    }
+  }
+
+  voices.phase[v]   = phase + step * n;
+  voices.elapsed[v] = elapsed + n;
+}
+
+// FIXED-Pfad: Oszillator, Gain und Mix in Q15 (int32), Produkte passen in 32 Bit. Der lineare Fade
+// ist elapsed × linearFadeQ24, der exp-Fade führt 1 - g in Q31 (64-Bit-Produkt) – in Q15 bliebe der
+// One-Pole bei kleinem alpha vor 1.0 stehen.
+template <WaveForm W, Transition T>
+static void renderRunQ15(int v, void* out, uint32_t n) {
+  int32_t* __restrict mix = static_cast<int32_t*>(out);
+  const uint32_t phase    = voices.phase[v];
+  const uint32_t step     = voices.step[v];
+  const uint32_t elapsed  = voices.elapsed[v];
+
+  if (T == Transition::TR_EXP) {
+    const uint32_t decay = expDecayQ31;
+    uint32_t       left  = voices.expLeft[v];
+    for (uint32_t i = 0; i < n; ++i) {
+      left = (uint32_t)(((uint64_t)left * decay) >> 31);
+      int32_t g = Q15_ONE - (int32_t)(left >> 16);
+      mix[i] += (generateWaveQ15(W, phase + step * i) * g) >> 15;
+    }
+    voices.expLeft[v] = left;
+  } else {
+    const uint32_t fadeStep = linearFadeQ24;
+    for (uint32_t i = 0; i < n; ++i) {
+      int32_t s = generateWaveQ15(W, phase + step * i);
+      if (T == Transition::TR_LINEAR) s = (s * (int32_t)(((elapsed + i) * fadeStep) >> 9)) >> 15;
+      mix[i] += s;
+    }
+  }
+
+  voices.phase[v]   = phase + step * n;
+  voices.elapsed[v] = elapsed + n;
+}
+
+#define KERNELS_FOR(K, W) { K<W, Transition::TR_LINEAR>, K<W, Transition::TR_EXP>, K<W, Transition::TR_NONE> }
+static const RenderKernel RENDER_KERNELS[4][3] = {
+  KERNELS_FOR(renderRun, WaveForm::WF_SINE),
+  KERNELS_FOR(renderRun, WaveForm::WF_SQUARE),
+  KERNELS_FOR(renderRun, WaveForm::WF_SAW),
+  KERNELS_FOR(renderRun, WaveForm::WF_TRI)
+};
+static const RenderKernel RENDER_KERNELS_Q15[4][3] = {
+  KERNELS_FOR(renderRunQ15, WaveForm::WF_SINE),
+  KERNELS_FOR(renderRunQ15, WaveForm::WF_SQUARE),
+  KERNELS_FOR(renderRunQ15, WaveForm::WF_SAW),
+  KERNELS_FOR(renderRunQ15, WaveForm::WF_TRI)
+};
+#undef KERNELS_FOR
+
+// Kernel-Tabelle des aktuellen Rechenwegs
+static const RenderKernel (*kernels)[3] = SYNTH_FIXED_POINT ? RENDER_KERNELS_Q15 : RENDER_KERNELS;
+
+// freq = 0 (auch die Stille am Ende kürzerer Tracks): trägt nichts zum Mix bei
+static void renderSilence(int v, void* /*mix*/, uint32_t n) {
+  voices.elapsed[v] += n;
+}
+
+// Wie ein Kernel, aber ohne Ausgabe: Zustand exakt so weiterschalten, als wäre gerendert worden
+static void advanceRun(int v, uint32_t n) {
+  voices.phase[v]   += voices.step[v] * n;   // Überlauf wie n Einzelschritte
+  voices.elapsed[v] += n;
+  if (voices.silent[v]) return;
+  // Laufender exp-Fade
+  if (currentMode == RenderMode::FLOAT && voices.gain[v] < 1.0f) {
+    float g = voices.gain[v];
+    for (uint32_t i = 0; i < n; ++i) {
+      g += (1.0f - g) * expAlpha;
+      if (g > 1.0f) g = 1.0f;
+    }
+    voices.gain[v] = g;
+  } else if (currentMode == RenderMode::FIXED && voices.expLeft[v] > 0) {
+    uint32_t left = voices.expLeft[v];
+    for (uint32_t i = 0; i < n; ++i) left = (uint32_t)(((uint64_t)left * expDecayQ31) >> 31);
+    voices.expLeft[v] = left;
+  }
+}
+
+// Segment seg von Stimme v ab Sample elapsed (relativ zum Segmentbeginn) starten. Phase und Fade
+// stehen danach so, als wäre das Segment von Anfang an gespielt worden.
+static inline void startSegment(int v, size_t seg, uint32_t elapsed) {
+  const TrackSegments& track = (*activeTracks)[v];
+  const TrackSegment& s = seg < track.size() ? track[seg] : SILENT_TAIL;
+  voices.segment[v]     = (int)seg;
+  voices.elapsed[v]     = elapsed;
+  voices.samplesLeft[v] = segEndSample(track, seg) - segStartSample(track, seg) - elapsed;
+  updatePhaseStep(v, s.freq);
+  voices.phase[v]       = voices.step[v] * elapsed;   // Überlauf wie elapsed Einzelschritte
+
+  uint32_t fade;
+  switch (s.transition) {
+    case Transition::TR_LINEAR: fade = linearFadeSamples; break;
+    case Transition::TR_EXP:    fade = expFadeSamples;    break;
+    default:                    fade = 0;                 break;
+  }
+  voices.fadeLeft[v] = fade > elapsed ? fade - elapsed : 0;
+  voices.gain[v]     = 1.0f;
+  voices.expLeft[v]  = 0;
+  if (s.transition == Transition::TR_EXP && voices.fadeLeft[v] > 0) {
+    if (elapsed == 0) {
+      voices.gain[v]    = EXP_FADE_START;
+      voices.expLeft[v] = EXP_LEFT_START_Q31;
+    } else if (currentMode == RenderMode::FLOAT) {
+      // Geschlossene Form des One-Pole: 1 - g = (1 - g0) * (1 - alpha)^elapsed
+      voices.gain[v] = 1.0f - (1.0f - EXP_FADE_START) * powf(1.0f - expAlpha, (float)elapsed);
+    } else {
+      // Q31 schrittweise wie im Kernel (elapsed < Fade-Länge), sonst weicht der Seek um 1 LSB ab
+      voices.expLeft[v] = EXP_LEFT_START_Q31;
+      for (uint32_t i = 0; i < elapsed; ++i) voices.expLeft[v] = (uint32_t)(((uint64_t)voices.expLeft[v] * expDecayQ31) >> 31);
+    }
+  }
+  Transition tr = voices.fadeLeft[v] > 0 ? s.transition : Transition::TR_NONE;
+  voices.kernel[v] = kernels[(uint8_t)s.waveForm & 3][(uint8_t)tr];
+
+  voices.silent[v] = !(s.freq > 0.0f);
+  if (voices.silent[v]) {
+    voices.fadeLeft[v] = 0;
+    voices.kernel[v]   = renderSilence;
+  }
+}
+
+// mix: float- bzw. int32-Puffer passend zum Rechenweg; nullptr = nur weiterschalten
+template <typename S>
+static void renderMix(S* mix, uint32_t count) {
+  for (uint8_t a = 0; a < voices.activeCount; ++a) {
+    const int v = voices.active[a];
+    const TrackSegments& track = (*activeTracks)[v];
+
+    uint32_t done = 0;
+    while (done < count) {
+      uint32_t run = count - done;
+      if (run > voices.samplesLeft[v]) run = voices.samplesLeft[v];
+      if (voices.fadeLeft[v] > 0 && run > voices.fadeLeft[v]) run = voices.fadeLeft[v];
+
+      if (mix != nullptr) voices.kernel[v](v, mix + done, run);
+      else                advanceRun(v, run);
+      done                  += run;
+      voices.samplesLeft[v] -= run;
+
+      // Fade fertig → eingeschwungener Kernel ohne Gain
+      if (voices.fadeLeft[v] > 0) {
+        voices.fadeLeft[v] -= run;
+        if (voices.fadeLeft[v] == 0) {
+          const TrackSegment& seg = track[voices.segment[v]];
+          voices.gain[v]    = 1.0f;
+          voices.expLeft[v] = 0;
+          voices.kernel[v]  = kernels[(uint8_t)seg.waveForm & 3][(uint8_t)Transition::TR_NONE];
+        }
+      }
+
+      // Segmentwechsel (nach dem letzten die Stille bis zum Schleifenende); auf 0 Samples
+      // gerundete Segmente überspringen, die Schleife ist mindestens ein Sample lang
+      size_t segIdx = voices.segment[v];
+      while (voices.samplesLeft[v] == 0) {
+        segIdx = (segIdx + 1) % (track.size() + 1);
+        startSegment(v, segIdx, 0);
+      }
+    }
+  }
+}
+
+// Nächsten Gate-Abschnitt innerhalb von höchstens max Samples weiterschalten; liefert die Länge
+// des Stücks, das ganz in einem Abschnitt liegt, und ob dieser offen ist
+static uint32_t gateStep(const GatePattern& gate, uint32_t max, bool& open) {
+  open = true;
+  if (gate.endsMs.empty()) return max;
+  if (gateRunLeft == 0) {
+    gateRun     = (gateRun + 1) % gate.endsMs.size();
+    gateRunLeft = gateRunSamples(gate, gateRun);
+    gateOpen    = gateRunIsOpen(gate, gateRun);
+  }
+  uint32_t run = max > gateRunLeft ? gateRunLeft : max;
+  gateRunLeft -= run;
+  open = gateOpen;
+  return run;
+}
+
+// Gate auf den Mix anwenden: konstante Abschnitte ohne Rechenaufwand (offen) bzw. als Nullen
+// (zu), dazwischen eine lineare Rampe über GATE_RAMP_MS. mix = nullptr: nur weiterschalten.
+static void applyGate(float* mix, uint32_t count) {
+  const GatePattern& gate = *activeGate;
+  if (gate.endsMs.empty() && gateGain == 1.0f) return;
+
+  uint32_t done = 0;
+  while (done < count) {
+    bool     open;
+    uint32_t run    = gateStep(gate, count - done, open);
+    float    target = open ? 1.0f : 0.0f;
+    float* p = mix != nullptr ? mix + done : nullptr;
+    uint32_t i = 0;
+    for (; i < run && gateGain != target; ++i) {
+      if (target > gateGain) { gateGain += gateRampStep; if (gateGain > target) gateGain = target; }
+      else                   { gateGain -= gateRampStep; if (gateGain < target) gateGain = target; }
+      if (p != nullptr) p[i] *= gateGain;
+    }
+    if (target == 0.0f && p != nullptr) {
+      for (; i < run; ++i) p[i] = 0.0f;
+    }
+    done += run;
+  }
+}
+
+// Wie applyGate(), Gain in Q15; das Produkt in der Rampe braucht 64 Bit (Mix bis TRACK_COUNT × Q15)
+static void applyGateQ15(int32_t* mix, uint32_t count) {
+  const GatePattern& gate = *activeGate;
+  if (gate.endsMs.empty() && gateGainQ15 == Q15_ONE) return;
+
+  uint32_t done = 0;
+  while (done < count) {
+    bool     open;
+    uint32_t run    = gateStep(gate, count - done, open);
+    int32_t  target = open ? Q15_ONE : 0;
+    int32_t* p      = mix != nullptr ? mix + done : nullptr;
+    uint32_t i = 0;
+    for (; i < run && gateGainQ15 != target; ++i) {
+      if (target > gateGainQ15) { gateGainQ15 += gateRampStepQ15; if (gateGainQ15 > target) gateGainQ15 = target; }
+      else                      { gateGainQ15 -= gateRampStepQ15; if (gateGainQ15 < target) gateGainQ15 = target; }
+      if (p != nullptr) p[i] = (int32_t)(((int64_t)p[i] * gateGainQ15) >> 15);
+    }
+    if (target == 0 && p != nullptr) {
+      for (; i < run; ++i) p[i] = 0;
+    }
+    done += run;
+  }
+}
+
+// Normierung (siehe MIX_FULL_SCALE_VOICES) + Quantisierung; begrenzt wird hart auf 0..255
+static void quantizeBlock(uint8_t* __restrict out, const float* __restrict mix, uint32_t n) {
+  const float gain = voices.mixGain;
+  for (uint32_t i = 0; i < n; ++i) {
+    int val = (int)(mix[i] * gain * 127.0f + 128.0f);
+    if (val < 0) val = 0; else if (val > 255) val = 255;
+    out[i] = (uint8_t)val;
+  }
+}
+
+// Dreieckverteilter Dither (Summe zweier 16-Bit-Zufallszahlen), zentriert, in der Q23-Skala von
+// quantizeBlockQ15(): ±1 LSB des 8-Bit-Ausgangs
+static inline int32_t nextDither() {
+  uint32_t x = ditherState;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  ditherState = x;
+  return ((int32_t)((x & 0xFFFF) + (x >> 16)) << 7) - (1 << 23);
+}
+
+// FIXED-Pfad: mixScale = mixGain × 127 in Q8 (seekTracks()), damit ist der Ausgang
+// 128 + mix × mixScale / 2^23 – ein Multiply und ein Shift, keine Division. Vorher wird der Mix
+// auf ±mixClip begrenzt, damit das Produkt in 32 Bit bleibt (ab dort ist der Ausgang ohnehin 0/255).
+static void quantizeBlockQ15(uint8_t* __restrict out, const int32_t* __restrict mix, uint32_t n) {
+  const int32_t scale = voices.mixScale;
+  const int32_t clip  = voices.mixClip;
+  if (!ditherOn) {
+    for (uint32_t i = 0; i < n; ++i) {
+      int32_t m = mix[i];
+      if (m > clip) m = clip; else if (m < -clip) m = -clip;
+      int32_t val = 128 + ((m * scale) >> 23);   // abrunden wie (int) im float-Pfad
+      if (val < 0) val = 0; else if (val > 255) val = 255;
+      out[i] = (uint8_t)val;
+    }
+    return;
+  }
+  // Stille bleibt exakt 128 (und der Zufallsgenerator steht), sonst wäre sie ein Rauschteppich
+  for (uint32_t i = 0; i < n; ++i) {
+    int32_t m = mix[i];
+    if (m > clip) m = clip; else if (m < -clip) m = -clip;
+    int32_t val = 128 + ((m * scale + (m != 0 ? nextDither() : 0)) >> 23);
+    if (val < 0) val = 0; else if (val > 255) val = 255;
+    out[i] = (uint8_t)val;
+  }
+}
+
+static float voiceMixGain(uint32_t count) {
+  if (count <= MIX_FULL_SCALE_VOICES) return count > 0 ? 1.0f / (float)count : 1.0f;
+  return 1.0f / sqrtf((float)(count * MIX_FULL_SCALE_VOICES));
+}
+
+// Alle Tracks auf Sample position der Schleife setzen (Binärsuche über endMs)
+static void seekTracks(uint64_t position) {
+  loopSamples = 0;
+  for (const auto& track : *activeTracks) {
+    if (!track.empty() && msToSampleOffset(track.back().endMs) > loopSamples) loopSamples = msToSampleOffset(track.back().endMs);
+  }
+
+  // Leere Tracks spielen nicht mit (auch nicht in der Normierung); leerer oder 0 ms langer Satz: keine Stimme
+  voices.activeCount = 0;
+  for (int v = 0; v < TRACK_COUNT; v++) {
+    voices.segment[v]     = 0;
+    voices.samplesLeft[v] = 0;
+    if (loopSamples > 0 && !(*activeTracks)[v].empty()) voices.active[voices.activeCount++] = (uint8_t)v;
+  }
+  voices.mixGain  = voiceMixGain(voices.activeCount);
+  voices.mixScale = (int32_t)lrintf(voices.mixGain * 127.0f * 256.0f);
+  voices.mixClip  = (INT32_MAX - (1 << 24)) / voices.mixScale;
+  ditherState     = DITHER_SEED;
+
+  for (uint8_t a = 0; a < voices.activeCount; ++a) {
+    const int v = voices.active[a];
+    const TrackSegments& track = (*activeTracks)[v];
+    uint32_t pos = (uint32_t)(position % loopSamples);
+    // Erstes Segment, das nach pos endet (0-lange davor werden übersprungen); track.size() = Stille
+    size_t seg = std::upper_bound(track.begin(), track.end(), pos,
+                                  [](uint32_t p, const TrackSegment& s) { return p < msToSampleOffset(s.endMs); })
+                 - track.begin();
+    startSegment(v, seg, pos - segStartSample(track, seg));
+  }
+}
+
+// Position der ersten Stimme in der Schleife
+static uint32_t tracksPosition() {
+  if (voices.activeCount == 0) return 0;
+  const int v = voices.active[0];
+  return segStartSample((*activeTracks)[v], voices.segment[v]) + voices.elapsed[v];
+}
+
+void initTracks() {
+  seekTracks(0);
+}
+
+void seekTracksMs(uint32_t ms) {
+  seekTracks(((uint64_t)ms * sampleRate + 500) / 1000);
+}
+
+// --------------------------------------
+// Hot-Swap
+// --------------------------------------
+
+void selectTracks(TrackSource source) {
+  requestedSource.store(source, std::memory_order_release);
+  platformAudioChanged();
+}
+
+void selectPreset(const TrackSet* preset) {
+  requestedPreset.store(preset, std::memory_order_release);
+  platformAudioChanged();
+}
+
+// Quelle oder gewähltes Preset weichen vom gespielten Satz ab
+static inline bool sourceChangePending(TrackSource source, const TrackSet* preset) {
+  return source != playingSource || (source == TrackSource::PRESET && preset != playingPreset);
+}
+
+TrackSet* acquireTrackSet() {
+  reclaimRetiredTracks();   // gibt ggf. den zuletzt ausgemusterten Slot frei
+  TrackSet* set = trackSetPool.acquire();
+  if (set != nullptr) {
+    for (auto& track : *set) track.clear();
+  }
+  return set;
+}
+
+void releaseTrackSet(TrackSet* set) {
+  trackSetPool.release(set);   // tracks/synthHorn liegen außerhalb des Pools und bleiben
+}
+
+size_t trackSetsInUse() {
+  return trackSetPool.inUse();
+}
+
+void publishTracks(TrackSet* next) {
+  reclaimRetiredTracks();
+  patchValidFrom.store(patchHead.load(std::memory_order_relaxed), std::memory_order_release);
+  // Noch nicht übernommener Vorgänger wurde nie gespielt → direkt verwerfen
+  TrackSet* superseded = pendingTracks.exchange(next, std::memory_order_acq_rel);
+  if (superseded != nullptr) releaseTrackSet(superseded);
+  platformAudioChanged();
+}
+
+void reclaimRetiredTracks() {
+  TrackSet* old = retiredTracks.exchange(nullptr, std::memory_order_acq_rel);
+  if (old != nullptr) releaseTrackSet(old);
+}
+
+bool queueSegmentPatch(const SegmentPatch& patch) {
+  if (patch.fields == 0) return true;   // 0 markiert im Ring einen erledigten Patch
+  uint32_t head = patchHead.load(std::memory_order_relaxed);
+  if (head - patchTail.load(std::memory_order_acquire) >= PATCH_QUEUE_SIZE) return false;
+  patchQueue[head & (PATCH_QUEUE_SIZE - 1)] = patch;
+  patchHead.store(head + 1, std::memory_order_release);
+  platformAudioChanged();
+  return true;
+}
+
+static inline bool patchPending() {
+  return patchTail.load(std::memory_order_relaxed) != patchHead.load(std::memory_order_acquire);
+}
+
+GatePattern* compileGate(bool startsOpen, const uint32_t* durationsMs, size_t count) {
+  reclaimRetiredGate();
+  GatePattern* gate = gatePool.acquire();
+  if (gate == nullptr) return nullptr;
+  gate->startsOpen = startsOpen;
+  gate->endsMs.clear();
+
+  uint32_t totalMs = 0;
+  for (size_t i = 0; i < count && !gate->endsMs.full(); ++i) {
+    totalMs += durationsMs[i];
+    gate->endsMs.push_back(totalMs);
+  }
+  return gate;
+}
+
+void releaseGate(GatePattern* gate) {
+  gatePool.release(gate);   // openGate liegt außerhalb des Pools
+}
+
+size_t gatesInUse() {
+  return gatePool.inUse();
+}
+
+void publishGate(GatePattern* next) {
+  reclaimRetiredGate();
+  GatePattern* superseded = pendingGate.exchange(next != nullptr ? next : &openGate, std::memory_order_acq_rel);
+  if (superseded != nullptr) releaseGate(superseded);
+  platformAudioChanged();
+}
+
+void advancePlayback(uint32_t ms) {
+  pendingAdvanceMs.fetch_add(ms, std::memory_order_acq_rel);
+}
+
+void reclaimRetiredGate() {
+  GatePattern* old = retiredGate.exchange(nullptr, std::memory_order_acq_rel);
+  if (old != nullptr) releaseGate(old);
+}
+
+static inline bool atSegmentBoundary() {
+  for (uint8_t a = 0; a < voices.activeCount; ++a) {
+    if (voices.elapsed[voices.active[a]] == 0) return true;
+  }
+  return false;
+}
+
+// Gespielten Satz wechseln; die Rate folgt dem neuen Satz
+static void useTracks(const TrackSet* set) {
+  activeTracks = set;
+  uint32_t rate = chooseSampleRate(*set);
+  if (rate != sampleRate) setSampleRate(rate);
+  initTracks();
+}
+
+// Gate um delta Samples weiterschalten (Binärsuche über endsMs); die Rampe bleibt wie sie ist
+static void advanceGate(uint32_t delta) {
+  const GatePattern& gate = *activeGate;
+  if (gate.endsMs.empty()) return;
+
+  uint32_t loop = msToSampleOffset(gate.endsMs.back());
+  if (loop == 0) return;
+  uint32_t end  = msToSampleOffset(gate.endsMs[gateRun]);
+  uint32_t pos  = end > gateRunLeft ? end - gateRunLeft : 0;
+  pos = (uint32_t)(((uint64_t)pos + delta) % loop);
+
+  gateRun     = std::upper_bound(gate.endsMs.begin(), gate.endsMs.end(), pos,
+                                 [](uint32_t p, uint32_t e) { return p < msToSampleOffset(e); })
+                - gate.endsMs.begin();
+  gateRunLeft = msToSampleOffset(gate.endsMs[gateRun]) - pos;
+  gateOpen    = gateRunIsOpen(gate, gateRun);
+}
+
+// Patch fällig? Spielt der Nutzersatz, erst an einer Grenze des Tracks vor oder auf dem Segment: Bis dorthin ändert
+// sich keine Segmentgrenze, der Seek danach setzt alle Stimmen exakt dorthin, wo sie ohnehin stehen
+static inline bool patchReady(const SegmentPatch& patch) {
+  // Ein wartender Upload ist älter als der Patch: erst übernehmen, dann patchen
+  if (pendingTracks.load(std::memory_order_acquire) != nullptr) return false;
+  if (activeTracks != userTracks || patch.track >= TRACK_COUNT) return true;
+  const int v = patch.track;
+  if (voices.samplesLeft[v] == 0) return true;   // Track spielt nicht mit
+  return voices.elapsed[v] == 0 && voices.segment[v] <= (int)patch.segment;
+}
+
+// Gibt überholte (vor dem letzten Upload) und erledigte Patches am Anfang des Rings frei
+static void dropDonePatches() {
+  uint32_t       tail      = patchTail.load(std::memory_order_relaxed);
+  const uint32_t head      = patchHead.load(std::memory_order_acquire);
+  const uint32_t validFrom = patchValidFrom.load(std::memory_order_acquire);
+  while (tail != head && ((int32_t)(validFrom - tail) > 0 || patchQueue[tail & (PATCH_QUEUE_SIZE - 1)].fields == 0)) {
+    tail++;
+  }
+  patchTail.store(tail, std::memory_order_release);
+}
+
+// Geht die wartenden Patches durch; je Track in Reihenfolge, ein noch nicht fälliger hält nur spätere
+// desselben Tracks auf. Mit apply werden die fälligen übernommen (changed: Nutzersatz geändert), sonst
+// nur gesucht. true, wenn mindestens einer fällig war.
+static bool processPatches(bool apply, bool& changed) {
+  dropDonePatches();
+  bool     ready   = false;
+  uint32_t waiting = 0;   // Bit je Track mit wartendem Patch
+  const uint32_t head = patchHead.load(std::memory_order_acquire);
+  for (uint32_t i = patchTail.load(std::memory_order_relaxed); i != head; ++i) {
+    SegmentPatch& patch = patchQueue[i & (PATCH_QUEUE_SIZE - 1)];
+    if (patch.fields == 0) continue;
+    const bool known = patch.track < TRACK_COUNT;
+    if ((known && (waiting >> patch.track) & 1) || !patchReady(patch)) {
+      if (known) waiting |= 1u << patch.track;
+      continue;
+    }
+
+    ready = true;
+    if (!apply) return true;
+    if (known && patch.segment < (*userTracks)[patch.track].size()) {
+      TrackSegment& seg = (*userTracks)[patch.track][patch.segment];
+      if (patch.fields & PATCH_FREQ)       seg.freq       = patch.values.freq;
+      if (patch.fields & PATCH_DURATION)   seg.duration   = patch.values.duration;
+      if (patch.fields & PATCH_WAVEFORM)   seg.waveForm   = patch.values.waveForm;
+      if (patch.fields & PATCH_TRANSITION) seg.transition = patch.values.transition;
+      changed = true;
+    }
+    patch.fields = 0;
+  }
+  if (apply) dropDonePatches();
+  return ready;
+}
+
+static inline bool patchDue() {
+  bool changed = false;
+  return patchPending() && processPatches(false, changed);
+}
+
+// Übernimmt alle fälligen Patches; true, wenn sich der Nutzersatz geändert hat
+static bool applyReadyPatches() {
+  bool changed = false;
+  processPatches(true, changed);
+  return changed;
+}
+
+static bool applyPendingChanges(bool blockStart) {
+  // Läuft nur im Audio-Pfad, am Anfang jedes Render-Abschnitts. Ein Wechsel des gespielten Satzes
+  // (und damit evtl. der Rate) nur am Blockanfang; sonst false, der Block endet hier.
+  TrackSource     source = requestedSource.load(std::memory_order_acquire);
+  const TrackSet* preset = requestedPreset.load(std::memory_order_acquire);
+  bool switchSource      = sourceChangePending(source, preset);
+
+  bool adoptTracks = pendingTracks.load(std::memory_order_acquire) != nullptr
+                     && retiredTracks.load(std::memory_order_acquire) == nullptr
+                     && (activeTracks != userTracks || atSegmentBoundary());
+  // Ein fälliger Patch kann die Rate ändern: im gespielten Nutzersatz ebenfalls erst am Blockanfang
+  bool patchesDue  = patchDue();
+  if (!blockStart && (switchSource || ((adoptTracks || patchesDue) && activeTracks == userTracks))) {
+    return false;
+  }
+
+  // Verschiebung nach einer Pause: Tracks und Gate laufen weiter, als hätte die Ausgabe nicht pausiert
+  uint32_t advanceMs = pendingAdvanceMs.exchange(0, std::memory_order_acq_rel);
+  if (advanceMs > 0) {
+    uint32_t delta = (uint32_t)((uint64_t)advanceMs * sampleRate / 1000);
+    seekTracks((uint64_t)tracksPosition() + delta);
+    advanceGate(delta);
+  }
+
+  if (patchesDue) {
+    uint32_t position = tracksPosition();   // vor dem Patch: segStartSample() liest die alten Grenzen
+    if (applyReadyPatches()) {
+      compileTimeline(*userTracks);
+      if (activeTracks == userTracks) {
+        uint32_t rate = chooseSampleRate(*userTracks);
+        if (rate != sampleRate) {
+          position = (uint32_t)((uint64_t)position * rate / sampleRate);
+          setSampleRate(rate);
+        }
+        seekTracks(position);
+      }
+    }
+  }
+
+  if (adoptTracks) {
+    TrackSet* next = pendingTracks.exchange(nullptr, std::memory_order_acq_rel);
+    if (next != nullptr) {
+      TrackSet* old = userTracks;
+      userTracks = next;
+      retiredTracks.store(old, std::memory_order_release);
+      if (activeTracks == old) useTracks(userTracks);   // Nutzersatz spielt (USER oder PRESET ohne Preset)
+    }
+  }
+
+  if (pendingGate.load(std::memory_order_acquire) != nullptr
+      && retiredGate.load(std::memory_order_acquire) == nullptr) {
+    GatePattern* next = pendingGate.exchange(nullptr, std::memory_order_acq_rel);
+    if (next != nullptr) {
+      retiredGate.store(activeGate, std::memory_order_release);
+      activeGate  = next;
+      gateRun     = 0;
+      gateRunLeft = next->endsMs.empty() ? 0 : gateRunSamples(*next, 0);
+      gateOpen    = next->endsMs.empty() || gateRunIsOpen(*next, 0);
+    }
+  }
+
+  if (switchSource) {
+    playingSource = source;
+    playingPreset = preset;
+    if (source == TrackSource::HORN)                              useTracks(&synthHorn);
+    else if (source == TrackSource::PRESET && preset != nullptr)  useTracks(preset);
+    else                                                          useTracks(userTracks);
+  }
+  return true;
+}
+
+static inline uint32_t samplesToNextBoundary() {
+  uint32_t n = UINT32_MAX;
+  for (uint8_t a = 0; a < voices.activeCount; ++a) {
+    uint32_t left = voices.samplesLeft[voices.active[a]];
+    if (left < n) n = left;
+  }
+  return n;
+}
+
+uint32_t silentSamplesAhead() {
+  // Steht eine Änderung an, entscheidet erst der nächste renderBlock()
+  if (pendingTracks.load(std::memory_order_relaxed) != nullptr
+      || patchDue()
+      || pendingGate.load(std::memory_order_relaxed) != nullptr
+      || pendingAdvanceMs.load(std::memory_order_relaxed) != 0
+      || sourceChangePending(requestedSource.load(std::memory_order_relaxed), requestedPreset.load(std::memory_order_relaxed))) {
+    return 0;
+  }
+
+  // Alle Stimmen in freq-0-Segmenten (oder keine): Mix = 0 bis zum ersten Segmentende
+  uint32_t tracksSilent = UINT32_MAX;
+  for (uint8_t a = 0; a < voices.activeCount; ++a) {
+    const int v = voices.active[a];
+    if (!voices.silent[v]) { tracksSilent = 0; break; }
+    if (voices.samplesLeft[v] < tracksSilent) tracksSilent = voices.samplesLeft[v];
+  }
+  if (tracksSilent == UINT32_MAX) tracksSilent = sampleRate;   // gar keine Segmente: in Sekundenschritten
+
+  // Gate zu und ausgeblendet: bis zum Ende des Abschnitts
+  uint32_t gateSilent = 0;
+  bool gateClosed = currentMode == RenderMode::FIXED ? gateGainQ15 == 0 : gateGain == 0.0f;
+  if (!activeGate->endsMs.empty() && !gateOpen && gateClosed) gateSilent = gateRunLeft;
+
+  uint32_t silent = tracksSilent > gateSilent ? tracksSilent : gateSilent;
+
+  // Ein wartender Patch wird erst an einer Segmentgrenze seines Tracks fällig: nicht darüber hinweg
+  if (patchPending()) {
+    const uint32_t head = patchHead.load(std::memory_order_acquire);
+    for (uint32_t i = patchTail.load(std::memory_order_relaxed); i != head; ++i) {
+      const SegmentPatch& patch = patchQueue[i & (PATCH_QUEUE_SIZE - 1)];
+      if (patch.fields == 0 || patch.track >= TRACK_COUNT) continue;
+      uint32_t left = voices.samplesLeft[patch.track];
+      if (left > 0 && left < silent) silent = left;
+    }
+  }
+  return silent;
+}
+
+void skipSilence(uint32_t count) {
+  renderMix<float>(nullptr, count);
+  if (currentMode == RenderMode::FIXED) applyGateQ15(nullptr, count);
+  else                                  applyGate(nullptr, count);
+}
+
+uint8_t renderSample() {
+  uint8_t val;
+  renderBlock(&val, 1);
+  return val;
+}
+
+size_t renderBlock(uint8_t* out, size_t count) {
+  // Füllt out mit bis zu count aufeinanderfolgenden 8-Bit-Samples (128 = Mittellage)
+  union {
+    float   f[RENDER_CHUNK];
+    int32_t q[RENDER_CHUNK];
+  } mix;
+  size_t done = 0;
+  while (count > 0) {
+    if (!applyPendingChanges(done == 0)) break;
+
+    uint32_t n = count < RENDER_CHUNK ? (uint32_t)count : RENDER_CHUNK;
+    // Wartet ein neuer Satz oder ein Patch, genau an der nächsten Segmentgrenze anhalten
+    if (activeTracks == userTracks && (pendingTracks.load(std::memory_order_relaxed) != nullptr || patchPending())) {
+      uint32_t untilBoundary = samplesToNextBoundary();
+      if (untilBoundary < n) n = untilBoundary;
+    }
+    if (currentMode == RenderMode::FIXED) {
+      for (uint32_t i = 0; i < n; ++i) mix.q[i] = 0;
+      renderMix(mix.q, n);
+      applyGateQ15(mix.q, n);
+      quantizeBlockQ15(out, mix.q, n);
+    } else {
+      for (uint32_t i = 0; i < n; ++i) mix.f[i] = 0.0f;
+      renderMix(mix.f, n);
+      applyGate(mix.f, n);
+      quantizeBlock(out, mix.f, n);
+    }
+
+    out   += n;
+    count -= n;
+    done  += n;
+  }
+  return done;
+}
+
+void setRenderMode(RenderMode mode, bool dither) {
+  // Nur aus dem Render-Task bzw. vor dem Start: die Stimmen werden an derselben Stelle neu
+  // aufgesetzt, damit Gains und Kernel zum neuen Rechenweg passen
+  uint32_t position = tracksPosition();
+  if (mode != currentMode) {
+    if (mode == RenderMode::FIXED) gateGainQ15 = (int32_t)lrintf(gateGain * (float)Q15_ONE);
+    else                           gateGain    = (float)gateGainQ15 / (float)Q15_ONE;
+  }
+  currentMode = mode;
+  kernels     = mode == RenderMode::FIXED ? RENDER_KERNELS_Q15 : RENDER_KERNELS;
+  ditherOn    = dither;
+  seekTracks(position);
+}
+
+RenderMode renderMode() {
+  return currentMode;
+}
+
+void playDacSample() {
+  platformDacWrite(renderSample());
+}
+
+WaveForm waveformFromString(const char* wf) {
+  if (strcmp(wf, "sine") == 0) return WaveForm::WF_SINE;
+  if (strcmp(wf, "square") == 0) return WaveForm::WF_SQUARE;
+  if (strcmp(wf, "sawtooth") == 0) return WaveForm::WF_SAW;
+  if (strcmp(wf, "triangle") == 0) return WaveForm::WF_TRI;
+  return WaveForm::WF_SINE;
+}
+
+Transition transitionFromString(const char* tr) {
+  if (strcmp(tr, "linear") == 0) return Transition::TR_LINEAR;
+  if (strcmp(tr, "exp") == 0) return Transition::TR_EXP;
+  // "none" oder unbekannt -> linear als Default
+  return Transition::TR_NONE;
+}
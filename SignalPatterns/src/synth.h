@@ -0,0 +1,249 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "pattern_storage.h"
+
+// --------------------------------------
+// Synth-Engine (plattformunabhängig)
+// --------------------------------------
+// Alles hier baut sowohl im esp32dev- als auch im native-Env.
+// Ausgabe und Zeitbasis laufen ausschließlich über platform.h.
+
+// --------------------------------------
+// Konfiguration
+// --------------------------------------
+constexpr uint32_t SAMPLE_RATE      = 44100;   // höchste Rate, Startwert der Engine
+constexpr uint32_t LINEAR_FADE_MS   = 50;      // Dauer des linearen Fade-Ins
+constexpr uint32_t EXP_TAU_MS       = 100;     // Zeitkonstante für exp-Fade-In
+
+// Sample-Rate pro Satz: die kleinste aus SAMPLE_RATES, deren Nyquist-Frequenz über der höchsten
+// relevanten Oberwelle liegt (Grundfrequenz × WAVEFORM_HARMONICS, etwa bis -20 dB). Mit
+// -DADAPTIVE_SAMPLE_RATE=0 läuft immer SAMPLE_RATE.
+#ifndef ADAPTIVE_SAMPLE_RATE
+#define ADAPTIVE_SAMPLE_RATE 1
+#endif
+constexpr uint32_t SAMPLE_RATES[]        = { 16000, 22050, 32000, SAMPLE_RATE };   // aufsteigend
+constexpr uint8_t  WAVEFORM_HARMONICS[4] = { 1, 9, 10, 3 };                        // sine, square, saw, tri
+
+// TR_EXP startet bei EXP_FADE_START und gilt als eingeschwungen, sobald 1 - g < EXP_FADE_SETTLED
+// (weit unter einem LSB der 8-Bit-Ausgabe); danach läuft der Track ohne Gain-Berechnung.
+constexpr float    EXP_FADE_START   = 0.001f;
+constexpr float    EXP_FADE_SETTLED = 0.001f;
+
+// Render-Puffer (float-Mix) pro Durchlauf in renderBlock(); größere Blöcke werden zerlegt
+constexpr uint32_t RENDER_CHUNK     = 64;
+
+// Gate: Rampe beim Öffnen/Schließen gegen Klicks
+constexpr uint32_t GATE_RAMP_MS     = 2;
+
+// Stimmen (Tracks) pro Satz, per build_flags änderbar (-DTRACK_COUNT=16). Gespielt werden nur die
+// nicht leeren Tracks eines Satzes. Jeder Track belegt in jedem Satz MAX_SEGMENTS_PER_TRACK × 12
+// Byte, im RAM liegen TRACK_SET_POOL_SIZE + 2 Sätze – mehr Stimmen brauchen ggf. weniger Segmente.
+#ifndef TRACK_COUNT
+#define TRACK_COUNT 4
+#endif
+static_assert(TRACK_COUNT >= 4 && TRACK_COUNT <= 32, "TRACK_COUNT: 4 (Standard-Sätze) bis 32");
+
+// Mix-Normierung: bis MIX_FULL_SCALE_VOICES Stimmen 1/N (Spitzen addieren sich, kein Clipping),
+// darüber 1/sqrt(N × MIX_FULL_SCALE_VOICES) – Leistung statt Spitze normiert, jede Verdopplung der
+// Stimmen kostet 3 dB statt 6 dB. Seltene Spitzen über Vollaussteuerung werden begrenzt.
+constexpr uint32_t MIX_FULL_SCALE_VOICES = 4;
+
+// Feste Kapazitäten der Muster-Daten (pattern_storage.h); Neuladen belegt keinen Heap
+constexpr uint16_t MAX_SEGMENTS_PER_TRACK = 64;
+constexpr uint16_t MAX_GATE_RUNS          = 256;
+
+// Live-Patches aus dem Editor, die noch nicht übernommen sind (Zweierpotenz)
+constexpr size_t   PATCH_QUEUE_SIZE       = 32;
+constexpr size_t   TRACK_SET_POOL_SIZE    = 4;   // Nutzersatz: aktiv, wartend, ausgemustert, im Aufbau
+constexpr size_t   GATE_POOL_SIZE         = 6;   // Audio-Pfad: aktiv, wartend, ausgemustert; Horn-Task: 2; im Aufbau
+
+// Rechenweg pro Sample: FLOAT oder FIXED (Q15, nur Ganzzahl-Arithmetik; für ESP32-C3/S2 ohne FPU).
+// Startwert per -DSYNTH_FIXED_POINT=1, -DSYNTH_DITHER=1 schaltet im FIXED-Pfad TPDF-Dither auf die
+// 8-Bit-Ausgabe ein. Umschalten zur Laufzeit mit setRenderMode() (z. B. für den Benchmark).
+#ifndef SYNTH_FIXED_POINT
+#define SYNTH_FIXED_POINT 0
+#endif
+#ifndef SYNTH_DITHER
+#define SYNTH_DITHER 0
+#endif
+constexpr int32_t  Q15_ONE          = 1 << 15;   // 1.0 im FIXED-Pfad
+
+// DDS-Oszillator: 32-Bit-Phase (2^32 = eine Periode), Sinus aus Tabelle mit linearer Interpolation
+constexpr uint32_t SINE_TABLE_BITS  = 8;
+constexpr uint32_t SINE_TABLE_SIZE  = 1u << SINE_TABLE_BITS;
+
+// --------------------------------------
+// Datentypen
+// --------------------------------------
+enum class WaveForm : uint8_t { WF_SINE=0, WF_SQUARE=1, WF_SAW=2, WF_TRI=3 };
+enum class Transition : uint8_t { TR_LINEAR=0, TR_EXP=1, TR_NONE=2 };
+enum class RenderMode : uint8_t { FLOAT, FIXED };
+
+// Gepackt (12 Byte, ohne Padding), Felder in der Reihenfolge des Binärformats
+struct TrackSegment {
+  float      freq;        // Hz
+  uint16_t   duration;    // ms
+  WaveForm   waveForm;    // siehe WaveForm
+  Transition transition;  // siehe Transition
+  uint32_t   endMs = 0;   // Ende ab Schleifenbeginn (Präfixsumme der Dauern); setzt compileTimeline()
+};
+static_assert(sizeof(TrackSegment) == 12, "TrackSegment soll ohne Padding bleiben");
+
+using TrackSegments = FixedList<TrackSegment, MAX_SEGMENTS_PER_TRACK>;
+using TrackSet      = std::array<TrackSegments, TRACK_COUNT>;
+
+// Änderung einzelner Felder eines Segments im Nutzersatz (Live-Editor). Die Werte setzen das Feld
+// absolut, ein Patch lässt sich also gefahrlos wiederholen.
+constexpr uint8_t PATCH_FREQ       = 1 << 0;
+constexpr uint8_t PATCH_DURATION   = 1 << 1;
+constexpr uint8_t PATCH_WAVEFORM   = 1 << 2;
+constexpr uint8_t PATCH_TRANSITION = 1 << 3;
+constexpr uint8_t PATCH_FIELDS     = PATCH_FREQ | PATCH_DURATION | PATCH_WAVEFORM | PATCH_TRANSITION;
+
+struct SegmentPatch {
+  uint8_t      track;
+  uint8_t      fields;    // PATCH_*-Bits
+  uint16_t     segment;
+  TrackSegment values;    // gilt nur für die Felder in fields
+};
+
+// Welcher Satz gespielt wird; Umschalten übernimmt der Audio-Pfad am Blockanfang. PRESET spielt
+// den mit selectPreset() gewählten Satz aus der Preset-Bank (preset_bank.h).
+enum class TrackSource : uint8_t { USER, HORN, PRESET };
+
+// An/Aus-Muster (z. B. Hupen-Pattern). Abschnitt i ist offen, wenn (i gerade) == startsOpen; nach
+// dem letzten Abschnitt beginnt das Muster von vorn. Die Grenzen stehen in ms, damit das Muster
+// unabhängig von der Sample-Rate bleibt; der Audio-Pfad rundet sie beim Erreichen auf Samples.
+struct GatePattern {
+  bool                                startsOpen;
+  FixedList<uint32_t, MAX_GATE_RUNS> endsMs;   // Ende je Abschnitt ab Musterbeginn, aufsteigend; leer = dauerhaft offen
+};
+
+// --------------------------------------
+// Globale Variablen (nur deklariert, in synth.cpp definiert)
+// --------------------------------------
+extern TrackSet tracks;       // Standard-Nutzersatz (statisch, wird nie freigegeben)
+extern TrackSet synthHorn;
+extern const TrackSet* activeTracks; // gehört dem Audio-Pfad; wird nie beschrieben (Presets liegen im Flash)
+extern TrackSet* userTracks;   // aktueller Nutzersatz; nur der Audio-Pfad schreibt
+
+// Aktuelle Rate der Engine; wechselt nur zu Beginn von renderBlock() (siehe dort), die Ausgabe
+// stellt ihren Takt danach nach
+extern uint32_t  sampleRate;
+
+// Hot-Swap (RCU): Producer legt den neuen Satz in pendingTracks ab, der Audio-Pfad übernimmt ihn
+// an der nächsten Segmentgrenze und legt den alten in retiredTracks ab. Freigegeben wird nur
+// vom Producer (reclaimRetiredTracks), nie auf dem Audio-Core. Nutzersätze stammen aus einem
+// festen Pool (acquireTrackSet()); "freigeben" heißt, den Slot zurückzugeben.
+extern std::atomic<TrackSet*>   pendingTracks;
+extern std::atomic<TrackSet*>   retiredTracks;
+extern std::atomic<TrackSource> requestedSource;
+extern std::atomic<const TrackSet*> requestedPreset;   // Satz für TrackSource::PRESET; nullptr = Nutzersatz
+
+// Gate wird wie die Tracks per RCU getauscht, aber sofort am nächsten Render-Abschnitt übernommen
+extern std::atomic<GatePattern*> pendingGate;
+extern std::atomic<GatePattern*> retiredGate;
+
+// Zustand aller Stimmen als Structure of Arrays (nur Audio-Pfad). Index = Track im Satz; active[]
+// listet die nicht leeren Tracks, nur über diese laufen Mix und Grenzsuche. Ein Kernel mischt in
+// float- (FLOAT) bzw. int32-Puffer (FIXED, Q15).
+typedef void (*RenderKernel)(int voice, void* mix, uint32_t n);
+
+struct VoiceState {
+  uint32_t     phase[TRACK_COUNT];         // DDS-Phase
+  uint32_t     step[TRACK_COUNT];          // Phaseninkrement pro Sample
+  uint32_t     elapsed[TRACK_COUNT];       // Samples seit Segmentbeginn
+  uint32_t     samplesLeft[TRACK_COUNT];   // bis Segmentende; 0 = Stimme spielt nicht
+  uint32_t     fadeLeft[TRACK_COUNT];      // verbleibende Fade-Samples, 0 = eingeschwungen
+  float        gain[TRACK_COUNT];          // exp-Fade (FLOAT)
+  uint32_t     expLeft[TRACK_COUNT];       // exp-Fade (FIXED): 1 - g in Q31, 0 = eingeschwungen
+  int          segment[TRACK_COUNT];       // track.size() = Stille bis Schleifenende
+  bool         silent[TRACK_COUNT];        // aktuelles Segment hat freq = 0
+  RenderKernel kernel[TRACK_COUNT];
+
+  uint8_t      activeCount;
+  uint8_t      active[TRACK_COUNT];
+  float        mixGain;                    // Normierung für activeCount Stimmen
+  int32_t      mixScale;                   // FIXED: mixGain × 127 in Q8 (Q15-Mix × mixScale >> 23 = 8-Bit-Auslenkung)
+  int32_t      mixClip;                    // FIXED: größter Mix-Betrag ohne Überlauf von Mix × mixScale
+};
+
+extern VoiceState voices;
+
+extern uint32_t  linearFadeSamples;
+extern float     invLinearFadeSamples;
+extern float     expAlpha;
+extern uint32_t  expFadeSamples;
+
+// --------------------------------------
+// Funktions-Prototypen
+// --------------------------------------
+void initSynth();
+void initTracks();                   // activeTracks von vorn; wie seekTracksMs(0)
+void seekTracksMs(uint32_t ms);      // activeTracks an Position ms (modulo Schleifenlänge), O(log n) je Track
+uint32_t chooseSampleRate(const TrackSet& set);
+void setSampleRate(uint32_t rate);   // Konstanten neu berechnen; danach initTracks()
+
+// Bereitet einen Satz einmalig zum Abspielen vor (abseits des Audio-Pfads, vor publishTracks()):
+// setzt TrackSegment::endMs. Die Schleife ist so lang wie der längste Track; kürzere schweigen bis
+// zu ihrem Ende. Die Segmentgrenzen in Samples werden aus endMs gerundet, alle Tracks enden damit
+// auf demselben Sample.
+void compileTimeline(TrackSet& set);
+
+TrackSet* acquireTrackSet();               // leerer Slot aus dem Pool; nullptr, wenn alle belegt sind
+void releaseTrackSet(TrackSet* set);       // nie veröffentlichten Satz zurückgeben
+size_t trackSetsInUse();                   // belegte Slots (Diagnose)
+void selectTracks(TrackSource source);
+// Satz für TrackSource::PRESET (read-only, wird nie freigegeben). Spielt PRESET schon, wechselt der
+// Audio-Pfad am nächsten Blockanfang; der Wechsel ist nur ein Zeiger, nichts wird geladen.
+void selectPreset(const TrackSet* preset);
+void publishTracks(TrackSet* next);
+void reclaimRetiredTracks();
+
+// Live-Patch für den Nutzersatz (ein Producer, z. B. der WebSocket-Handler). Der Audio-Pfad ändert
+// das Segment an Ort und Stelle, ohne Kopie und ohne neuen Satz. Spielt der Nutzersatz, wartet er
+// damit, bis der Track an einer Segmentgrenze vor oder auf dem Segment steht: die Position in der
+// Schleife bleibt, das geänderte Segment klingt beim nächsten Erreichen neu. Ungültige Indizes
+// werden verworfen. false: Queue voll (der Audio-Pfad läuft gerade nicht).
+bool queueSegmentPatch(const SegmentPatch& patch);
+
+// Gates stammen ebenfalls aus einem Pool; compileGate() liefert nullptr, wenn alle Slots belegt
+// sind, und kürzt Muster über MAX_GATE_RUNS Abschnitte
+GatePattern* compileGate(bool startsOpen, const uint32_t* durationsMs, size_t count);
+void releaseGate(GatePattern* gate);   // nicht (mehr) veröffentlichtes Gate zurückgeben
+size_t gatesInUse();
+void publishGate(GatePattern* next);   // nullptr: Gate aus (dauerhaft offen)
+void reclaimRetiredGate();
+
+// Tracks und Gate am nächsten Blockanfang um ms weiterschalten, z. B. um nach einer Pause dort
+// weiterzuspielen, wo die Schleife ohne Pause wäre. Phase und Fades stimmen danach mit dem
+// durchgehenden Spielen überein. Mehrere Aufrufe vor der Übernahme addieren sich.
+void advancePlayback(uint32_t ms);
+
+// Zwischen zwei renderBlock()-Aufrufen; spielt an derselben Stelle im neuen Rechenweg weiter
+void setRenderMode(RenderMode mode, bool dither = false);
+RenderMode renderMode();
+
+float generateWave(WaveForm waveForm, uint32_t phase);
+int32_t generateWaveQ15(WaveForm waveForm, uint32_t phase);   // -Q15_ONE..+Q15_ONE
+
+uint8_t renderSample();
+// Liefert die Anzahl gerenderter Samples, alle mit sampleRate. Steht ein Satzwechsel an, endet der
+// Block davor (< count); der Wechsel samt neuer Rate folgt am Anfang des nächsten Aufrufs.
+size_t renderBlock(uint8_t* out, size_t count);
+void playDacSample();
+
+// Stille: wie viele der nächsten Samples sicher Mittellage (128) sind – alle Tracks in freq-0-
+// Segmenten bzw. leer, oder das Gate ist zu. 0, solange eine Änderung auf Übernahme wartet.
+uint32_t silentSamplesAhead();
+// Überspringt count ≤ silentSamplesAhead() Samples ohne zu rendern; der Zustand ist danach derselbe
+// wie nach renderBlock() über dieselbe Strecke
+void skipSilence(uint32_t count);
+
+WaveForm waveformFromString(const char* wf);
+Transition transitionFromString(const char* tr);
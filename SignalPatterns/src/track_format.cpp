@@ -0,0 +1,189 @@
+#include <string.h>
+
+#include "track_format.h"
+
+// Halbbyte-Tabelle (64 Bytes) statt bitweise: die CRC läuft auch je Live-Patch über Spiegel und Snapshot
+static const uint32_t CRC32_NIBBLE[16] = {
+  0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+  0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+};
+
+uint32_t crc32(const uint8_t* data, size_t len, uint32_t crc) {
+  crc = ~crc;
+  for (size_t i = 0; i < len; ++i) {
+    crc ^= data[i];
+    crc = (crc >> 4) ^ CRC32_NIBBLE[crc & 0x0F];
+    crc = (crc >> 4) ^ CRC32_NIBBLE[crc & 0x0F];
+  }
+  return ~crc;
+}
+
+static inline void putU16(uint8_t* p, uint16_t v) { memcpy(p, &v, 2); }
+static inline void putU32(uint8_t* p, uint32_t v) { memcpy(p, &v, 4); }
+static inline uint16_t getU16(const uint8_t* p) { uint16_t v; memcpy(&v, p, 2); return v; }
+static inline uint32_t getU32(const uint8_t* p) { uint32_t v; memcpy(&v, p, 4); return v; }
+
+size_t tracksBinarySize(const TrackSet& set) {
+  size_t segments = 0;
+  for (const auto& track : set) segments += track.size();
+  return tracksBinaryHeader(set.size()) + segments * TRACKS_BINARY_SEGMENT + 4;
+}
+
+size_t encodeTracksBinary(const TrackSet& set, uint8_t* out, size_t capacity) {
+  size_t size = tracksBinarySize(set);
+  if (size > capacity) return 0;
+
+  memcpy(out, TRACKS_BINARY_MAGIC, 4);
+  out[4] = TRACKS_BINARY_VERSION;
+  out[5] = (uint8_t)set.size();
+  putU16(out + 6, 0);
+  for (size_t t = 0; t < set.size(); ++t) {
+    putU16(out + 8 + 2 * t, (uint16_t)set[t].size());
+  }
+
+  uint8_t* p = out + tracksBinaryHeader(set.size());
+  for (const auto& track : set) {
+    for (const TrackSegment& seg : track) {
+      memcpy(p, &seg.freq, 4);
+      putU16(p + 4, seg.duration);
+      p[6] = (uint8_t)seg.waveForm;
+      p[7] = (uint8_t)seg.transition;
+      p += TRACKS_BINARY_SEGMENT;
+    }
+  }
+
+  putU32(p, crc32(out, size - 4));
+  return size;
+}
+
+bool decodeTracksBinary(const uint8_t* data, size_t len, TrackSet& out) {
+  if (len < 8) return false;
+  if (memcmp(data, TRACKS_BINARY_MAGIC, 4) != 0) return false;
+  if (data[4] != TRACKS_BINARY_VERSION) return false;
+
+  const size_t trackCount = data[5];
+  const size_t header     = tracksBinaryHeader(trackCount);
+  if (len < header + 4) return false;
+
+  size_t segments = 0;
+  for (size_t t = 0; t < trackCount; ++t) {
+    uint16_t count = getU16(data + 8 + 2 * t);
+    if (count > MAX_SEGMENTS_PER_TRACK) return false;
+    segments += count;
+  }
+  size_t size = header + segments * TRACKS_BINARY_SEGMENT + 4;
+  if (len != size) return false;
+  if (getU32(data + size - 4) != crc32(data, size - 4)) return false;
+
+  const uint8_t* p = data + header;
+  for (auto& track : out) track.clear();
+  for (size_t t = 0; t < trackCount; ++t) {
+    if (t >= out.size()) break;   // mehr Tracks als TRACK_COUNT
+    uint16_t count = getU16(data + 8 + 2 * t);
+    for (uint16_t i = 0; i < count; ++i) {
+      TrackSegment seg;
+      memcpy(&seg.freq, p, 4);
+      seg.duration   = getU16(p + 4);
+      seg.waveForm   = (WaveForm)(p[6] & 3);
+      seg.transition = p[7] <= (uint8_t)Transition::TR_NONE ? (Transition)p[7] : Transition::TR_NONE;
+      out[t].push_back(seg);
+      p += TRACKS_BINARY_SEGMENT;
+    }
+  }
+  return true;
+}
+
+// --------------------------------------
+// Live-Patch
+// --------------------------------------
+
+bool decodePatchMessage(const uint8_t* data, size_t len, SegmentPatch& patch, uint32_t& version) {
+  if (len < PATCH_MESSAGE_HEADER || data[0] != (uint8_t)PatchMessage::SEGMENT) return false;
+  const uint8_t fields = data[8];
+  if (fields == 0 || (fields & ~PATCH_FIELDS) != 0) return false;
+
+  size_t size = PATCH_MESSAGE_HEADER;
+  if (fields & PATCH_FREQ)       size += 4;
+  if (fields & PATCH_DURATION)   size += 2;
+  if (fields & PATCH_WAVEFORM)   size += 1;
+  if (fields & PATCH_TRANSITION) size += 1;
+  if (len != size) return false;
+
+  patch.track   = data[1];
+  patch.segment = getU16(data + 2);
+  patch.fields  = fields;
+  patch.values  = TrackSegment{};
+  version       = getU32(data + 4);
+
+  const uint8_t* p = data + PATCH_MESSAGE_HEADER;
+  if (fields & PATCH_FREQ) {
+    memcpy(&patch.values.freq, p, 4);
+    if (!(patch.values.freq >= 0.0f)) return false;
+    p += 4;
+  }
+  if (fields & PATCH_DURATION) {
+    patch.values.duration = getU16(p);
+    p += 2;
+  }
+  if (fields & PATCH_WAVEFORM) {
+    if (*p > (uint8_t)WaveForm::WF_TRI) return false;
+    patch.values.waveForm = (WaveForm)*p++;
+  }
+  if (fields & PATCH_TRANSITION) {
+    if (*p > (uint8_t)Transition::TR_NONE) return false;
+    patch.values.transition = (Transition)*p++;
+  }
+  return true;
+}
+
+size_t encodePatchMessage(const SegmentPatch& patch, uint32_t version, uint8_t* out, size_t capacity) {
+  if (capacity < PATCH_MESSAGE_MAX_SIZE) return 0;
+  out[0] = (uint8_t)PatchMessage::SEGMENT;
+  out[1] = patch.track;
+  putU16(out + 2, patch.segment);
+  putU32(out + 4, version);
+  out[8] = patch.fields & PATCH_FIELDS;
+
+  uint8_t* p = out + PATCH_MESSAGE_HEADER;
+  if (patch.fields & PATCH_FREQ)       { memcpy(p, &patch.values.freq, 4); p += 4; }
+  if (patch.fields & PATCH_DURATION)   { putU16(p, patch.values.duration); p += 2; }
+  if (patch.fields & PATCH_WAVEFORM)   *p++ = (uint8_t)patch.values.waveForm;
+  if (patch.fields & PATCH_TRANSITION) *p++ = (uint8_t)patch.values.transition;
+  return p - out;
+}
+
+void encodePatchAck(PatchStatus status, uint32_t version, uint8_t* out) {
+  out[0] = (uint8_t)PatchMessage::ACK;
+  out[1] = (uint8_t)status;
+  putU16(out + 2, 0);
+  putU32(out + 4, version);
+}
+
+// Offset des Segments in gültigen tracks.bin-Bytes; 0, wenn Track oder Segment fehlt
+static size_t segmentOffset(const uint8_t* data, size_t len, size_t track, size_t segment) {
+  if (len < 8 || track >= data[5]) return 0;
+  const size_t header = tracksBinaryHeader(data[5]);
+  if (len < header + 4 || segment >= getU16(data + 8 + 2 * track)) return 0;
+
+  size_t offset = header;
+  for (size_t t = 0; t < track; ++t) offset += getU16(data + 8 + 2 * t) * TRACKS_BINARY_SEGMENT;
+  offset += segment * TRACKS_BINARY_SEGMENT;
+  return offset + TRACKS_BINARY_SEGMENT <= len - 4 ? offset : 0;
+}
+
+bool tracksBinaryHasSegment(const uint8_t* data, size_t len, size_t track, size_t segment) {
+  return segmentOffset(data, len, track, segment) != 0;
+}
+
+bool patchTracksBinary(uint8_t* data, size_t len, const SegmentPatch& patch) {
+  const size_t offset = segmentOffset(data, len, patch.track, patch.segment);
+  if (offset == 0) return false;
+
+  uint8_t* p = data + offset;
+  if (patch.fields & PATCH_FREQ)       memcpy(p, &patch.values.freq, 4);
+  if (patch.fields & PATCH_DURATION)   putU16(p + 4, patch.values.duration);
+  if (patch.fields & PATCH_WAVEFORM)   p[6] = (uint8_t)patch.values.waveForm;
+  if (patch.fields & PATCH_TRANSITION) p[7] = (uint8_t)patch.values.transition;
+  putU32(data + len - 4, crc32(data, len - 4));
+  return true;
+}
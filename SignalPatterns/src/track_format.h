@@ -0,0 +1,70 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "synth.h"
+#include "track_parser.h"
+
+// --------------------------------------
+// Binäres Track-Format (Speicher + Übertragung)
+// --------------------------------------
+// Little Endian, ohne Padding:
+//    0  char[4]   "SPTK"
+//    4  uint8     Version (TRACKS_BINARY_VERSION)
+//    5  uint8     Anzahl Tracks n (TRACK_COUNT des Schreibers)
+//    6  uint16    reserviert (0)
+//    8  uint16[n] Segmente pro Track
+// 8+2n  Segmente aller Tracks hintereinander, je 8 Byte:
+//         float freq, uint16 duration, uint8 waveForm, uint8 transition
+//  end  uint32    CRC32 über alle vorherigen Bytes
+//
+// Laden ist ein Längen-/CRC-Check und eine Kopierschleife, kein JSON. Mit n = 4 ist das Layout das
+// ursprüngliche; Dateien mit mehr Tracks als TRACK_COUNT werden geladen, die übrigen verworfen.
+
+constexpr uint8_t  TRACKS_BINARY_MAGIC[4]   = { 'S', 'P', 'T', 'K' };
+constexpr uint8_t  TRACKS_BINARY_VERSION    = 1;
+constexpr size_t   TRACKS_BINARY_SEGMENT    = 8;
+constexpr size_t   tracksBinaryHeader(size_t trackCount) { return 8 + 2 * trackCount; }
+constexpr size_t   TRACKS_BINARY_MAX_SIZE   = tracksBinaryHeader(TRACK_COUNT) + TRACK_COUNT * MAX_SEGMENTS_PER_TRACK * TRACKS_BINARY_SEGMENT + 4;
+
+uint32_t crc32(const uint8_t* data, size_t len, uint32_t crc = 0);
+
+size_t tracksBinarySize(const TrackSet& set);
+size_t encodeTracksBinary(const TrackSet& set, uint8_t* out, size_t capacity);   // 0 bei zu kleinem Puffer
+bool   decodeTracksBinary(const uint8_t* data, size_t len, TrackSet& out);
+
+// --------------------------------------
+// Live-Patch (WebSocket /ws, Editor ↔ Gerät)
+// --------------------------------------
+// Ein Segment ändern statt den ganzen Satz als JSON hochzuladen. Little Endian, ohne Padding:
+//    0  uint8     PatchMessage::SEGMENT
+//    1  uint8     Track
+//    2  uint16    Segment
+//    4  uint32    Version (vom Editor hochgezählt, kommt in der Quittung zurück)
+//    8  uint8     Felder (PATCH_*-Bits aus synth.h)
+//    9  nur die gesetzten Felder, in dieser Reihenfolge:
+//         float freq, uint16 duration, uint8 waveForm, uint8 transition
+//
+// Quittung:
+//    0  uint8     PatchMessage::ACK
+//    1  uint8     PatchStatus
+//    2  uint16    reserviert (0)
+//    4  uint32    Version des quittierten Patches
+
+enum class PatchMessage : uint8_t { SEGMENT = 1, ACK = 2 };
+enum class PatchStatus  : uint8_t { OK = 0, BAD_MESSAGE = 1, BAD_SEGMENT = 2, BUSY = 3 };
+
+constexpr size_t PATCH_MESSAGE_HEADER   = 9;
+constexpr size_t PATCH_MESSAGE_MAX_SIZE = PATCH_MESSAGE_HEADER + 4 + 2 + 1 + 1;
+constexpr size_t PATCH_ACK_SIZE         = 8;
+
+// Prüft Typ, Felder, Länge und Werte (Wellenform/Übergang, freq >= 0); den Index prüft der Aufrufer
+bool   decodePatchMessage(const uint8_t* data, size_t len, SegmentPatch& patch, uint32_t& version);
+size_t encodePatchMessage(const SegmentPatch& patch, uint32_t version, uint8_t* out, size_t capacity);   // 0 bei zu kleinem Puffer
+void   encodePatchAck(PatchStatus status, uint32_t version, uint8_t* out);                              // PATCH_ACK_SIZE Bytes
+
+// Direkt auf gültigen tracks.bin-Bytes (Spiegel des Nutzersatzes); patchTracksBinary() berechnet die
+// CRC neu und gibt false zurück, wenn Track oder Segment dort nicht existiert
+bool   tracksBinaryHasSegment(const uint8_t* data, size_t len, size_t track, size_t segment);
+bool   patchTracksBinary(uint8_t* data, size_t len, const SegmentPatch& patch);
@@ -0,0 +1,225 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "track_parser.h"
+#include "platform.h"
+
+void TrackJsonParser::begin(TrackSet& out) {
+  target = &out;
+  for (auto& track : out) track.clear();
+
+  errorMessage    = nullptr;
+  droppedSegments = 0;
+  droppedTracks   = 0;
+
+  lex           = Lex::VALUE;
+  unicodeDigits = 0;
+  depth         = 0;
+  expectKey     = false;
+  tokenLen      = 0;
+  token[0]      = '\0';
+  key[0]        = '\0';
+
+  inTracksArray = false;
+  trackIdx      = -1;
+  inSegment     = false;
+}
+
+void TrackJsonParser::fail(const char* message) {
+  if (errorMessage == nullptr) errorMessage = message;
+}
+
+void TrackJsonParser::open(bool object) {
+  if (depth >= TRACK_PARSER_MAX_DEPTH) { fail("JSON zu tief verschachtelt"); return; }
+  uint8_t level = depth + 1;
+
+  if (!object && level == 2 && isObject[0] && strcmp(key, "tracks") == 0) {
+    inTracksArray = true;
+  } else if (!object && level == 3 && inTracksArray) {
+    trackIdx++;
+    if (trackIdx >= (int16_t)target->size()) droppedTracks++;
+  } else if (object && level == 4 && inTracksArray && trackIdx >= 0 && trackIdx < (int16_t)target->size()) {
+    inSegment = true;
+    // Defaults wie bisher: fehlende Felder → 0 Hz, Sinus, 0 ms, keine Transition
+    segment = TrackSegment{ 0.0f, 0, waveformFromString(""), transitionFromString("") };
+  }
+
+  isObject[depth] = object;
+  depth           = level;
+  expectKey       = object;
+}
+
+void TrackJsonParser::close(bool object) {
+  if (depth == 0 || isObject[depth - 1] != object) { fail("Klammern passen nicht"); return; }
+
+  if (object && depth == 4 && inSegment) {
+    if (!(*target)[trackIdx].push_back(segment)) droppedSegments++;
+    inSegment = false;
+  } else if (!object && depth == 2 && inTracksArray) {
+    inTracksArray = false;
+  }
+
+  depth--;
+  expectKey = false;
+  if (depth == 0) lex = Lex::DONE;
+}
+
+void TrackJsonParser::onString() {
+  if (depth > 0 && isObject[depth - 1] && expectKey) {
+    memcpy(key, token, tokenLen + 1);
+    expectKey = false;
+    return;
+  }
+  if (!inSegment || depth != 4) return;
+
+  if (strcmp(key, "waveform") == 0)        segment.waveForm   = waveformFromString(token);
+  else if (strcmp(key, "transition") == 0) segment.transition = transitionFromString(token);
+}
+
+void TrackJsonParser::onScalar() {
+  if (token[0] == 't' || token[0] == 'f' || token[0] == 'n') {
+    if (strcmp(token, "true") != 0 && strcmp(token, "false") != 0 && strcmp(token, "null") != 0) {
+      fail("Unbekanntes Literal");
+    }
+    return;
+  }
+  if (!inSegment || depth != 4) return;
+
+  if (strcmp(key, "freq") == 0) {
+    segment.freq = strtof(token, nullptr);
+  } else if (strcmp(key, "duration") == 0) {
+    long ms = strtol(token, nullptr, 10);
+    segment.duration = (uint16_t)(ms < 0 ? 0 : (ms > UINT16_MAX ? UINT16_MAX : ms));
+  }
+}
+
+void TrackJsonParser::endToken() {
+  token[tokenLen] = '\0';
+  onScalar();
+  tokenLen = 0;
+  lex      = Lex::VALUE;
+}
+
+bool TrackJsonParser::feed(const char* data, size_t len) {
+  size_t i = 0;
+  while (i < len && errorMessage == nullptr) {
+    char c = data[i];
+
+    switch (lex) {
+      case Lex::STRING:
+        if (c == '"') {
+          token[tokenLen] = '\0';
+          onString();
+          tokenLen = 0;
+          lex      = Lex::VALUE;
+        } else if (c == '\\') {
+          lex = Lex::STRING_ESCAPE;
+        } else if (tokenLen < TRACK_PARSER_TOKEN_LEN) {
+          token[tokenLen++] = c;   // zu lange Strings werden gekürzt
+        }
+        i++;
+        continue;
+
+      case Lex::STRING_ESCAPE:
+        if (c == 'u') {
+          lex           = Lex::STRING_UNICODE;
+          unicodeDigits = 0;
+          c             = '?';
+        } else {
+          lex = Lex::STRING;
+        }
+        if (tokenLen < TRACK_PARSER_TOKEN_LEN) token[tokenLen++] = c;
+        i++;
+        continue;
+
+      case Lex::STRING_UNICODE:
+        if (++unicodeDigits == 4) lex = Lex::STRING;
+        i++;
+        continue;
+
+      case Lex::NUMBER:
+        if ((c >= '0' && c <= '9') || c == '.' || c == '-' || c == '+' || c == 'e' || c == 'E') {
+          if (tokenLen < TRACK_PARSER_TOKEN_LEN) token[tokenLen++] = c;
+          i++;
+          continue;
+        }
+        endToken();   // Zeichen gehört schon zum nächsten Token
+        continue;
+
+      case Lex::LITERAL:
+        if (c >= 'a' && c <= 'z') {
+          if (tokenLen < TRACK_PARSER_TOKEN_LEN) token[tokenLen++] = c;
+          i++;
+          continue;
+        }
+        endToken();
+        continue;
+
+      case Lex::DONE:
+        if (c != ' ' && c != '\t' && c != '\r' && c != '\n') fail("Daten nach Dokumentende");
+        i++;
+        continue;
+
+      case Lex::VALUE:
+        break;
+    }
+
+    switch (c) {
+      case ' ': case '\t': case '\r': case '\n': case ':':
+        break;
+      case ',':
+        if (depth > 0 && isObject[depth - 1]) expectKey = true;
+        break;
+      case '{': open(true);   break;
+      case '[': open(false);  break;
+      case '}': close(true);  break;
+      case ']': close(false); break;
+      case '"':
+        lex      = Lex::STRING;
+        tokenLen = 0;
+        break;
+      default:
+        if ((c >= '0' && c <= '9') || c == '-') {
+          lex = Lex::NUMBER;
+        } else if (c == 't' || c == 'f' || c == 'n') {
+          lex = Lex::LITERAL;
+        } else {
+          fail("Unerwartetes Zeichen");
+          break;
+        }
+        tokenLen = 0;
+        token[tokenLen++] = c;
+        break;
+    }
+    i++;
+  }
+
+  return errorMessage == nullptr;
+}
+
+bool TrackJsonParser::finish() {
+  if (errorMessage == nullptr && lex != Lex::DONE) fail("JSON unvollständig");
+  return errorMessage == nullptr;
+}
+
+TrackSet parseTracksFromJson(const char* jsonTracks) {
+  TrackSet tracksOut;
+  TrackJsonParser parser;
+  parser.begin(tracksOut);
+  parser.feed(jsonTracks, strlen(jsonTracks));
+
+  if (!parser.finish()) {
+    char msg[64];
+    snprintf(msg, sizeof(msg), "Track-JSON fehlerhaft: %s", parser.error());
+    platformLog(msg);
+    return TrackSet{}; // leer zurückgeben
+  }
+  if (parser.truncated()) {
+    char msg[80];
+    snprintf(msg, sizeof(msg), "Track-JSON gekürzt: %u Segmente, %u Tracks verworfen",
+             (unsigned)parser.droppedSegments, (unsigned)parser.droppedTracks);
+    platformLog(msg);
+  }
+  return tracksOut;
+}
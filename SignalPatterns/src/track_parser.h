@@ -0,0 +1,64 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "synth.h"
+
+// --------------------------------------
+// Streaming-Parser für das Track-JSON
+// --------------------------------------
+// Format wie vom Editor gesendet:
+//   {"tracks":[[{"freq":440,"waveform":"square","duration":750,"transition":"none"}, ...], ...]}
+//
+// Nimmt die Eingabe in beliebigen Stücken entgegen (z. B. direkt aus dem Request-Body) und
+// schreibt Segmente sofort in den Zielsatz; es wird kein DOM aufgebaut. Der Speicherbedarf ist
+// fest: Die Tracks haben feste Kapazität (MAX_SEGMENTS_PER_TRACK, synth.h), Tracks über
+// TRACK_COUNT hinaus und Segmente über das Limit hinaus werden verworfen.
+
+constexpr uint8_t  TRACK_PARSER_MAX_DEPTH = 8;
+constexpr uint8_t  TRACK_PARSER_TOKEN_LEN = 24;
+
+struct TrackJsonParser {
+  void begin(TrackSet& out);
+  bool feed(const char* data, size_t len);   // false: Syntaxfehler, weitere Eingabe wird ignoriert
+  bool finish();                             // true: vollständiges, gültiges Dokument
+
+  bool        failed()    const { return errorMessage != nullptr; }
+  const char* error()     const { return errorMessage; }
+  bool        truncated() const { return droppedSegments > 0 || droppedTracks > 0; }
+
+  uint16_t droppedSegments;
+  uint16_t droppedTracks;
+
+ private:
+  enum class Lex : uint8_t { VALUE, STRING, STRING_ESCAPE, STRING_UNICODE, NUMBER, LITERAL, DONE };
+
+  void fail(const char* message);
+  void open(bool isObject);
+  void close(bool isObject);
+  void onString();
+  void onScalar();
+  void endToken();
+
+  TrackSet*    target;
+  const char*  errorMessage;
+
+  Lex          lex;
+  uint8_t      unicodeDigits;
+  uint8_t      depth;
+  bool         isObject[TRACK_PARSER_MAX_DEPTH];
+  bool         expectKey;
+
+  char         token[TRACK_PARSER_TOKEN_LEN + 1];
+  uint8_t      tokenLen;
+  char         key[TRACK_PARSER_TOKEN_LEN + 1];
+
+  bool         inTracksArray;   // Ebene 2: "tracks"-Array
+  int16_t      trackIdx;        // Ebene 3: aktueller Track
+  bool         inSegment;       // Ebene 4: Segment-Objekt
+  TrackSegment segment;
+};
+
+// Komplettes Dokument parsen; bei Fehler wird geloggt und ein leerer Satz geliefert
+TrackSet parseTracksFromJson(const char* jsonTracks);
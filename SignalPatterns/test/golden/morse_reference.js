@@ -0,0 +1,54 @@
+// Erwartete Morse-Laufzeiten aus dem Editor (data/script.js, generateMorseSegments()) für test/golden/morse.txt
+//   node test/golden/morse_reference.js test/golden/morse.txt [--update]
+// Liest MORSE_CODE und generateMorseSegments() direkt aus data/script.js und bereitet den Text wie
+// updateMorseVisualization()/drawMorsePwmLine() vor (ß → ẞ, toUpperCase(), Leerzeichen anhängen).
+// Gleiche Zustände hintereinander werden wie im MorseCompiler zu einer Laufzeit zusammengefasst.
+// Exit-Code 1 bei Abweichung; --update schreibt die Werte des Editors zurück.
+const fs   = require('fs');
+const path = require('path');
+
+const goldenPath = process.argv[2];
+const update     = process.argv[3] === '--update';
+if (!goldenPath) {
+  console.error('morse_reference.js <morse.txt> [--update]');
+  process.exit(2);
+}
+
+const script = fs.readFileSync(path.join(__dirname, '../../data/script.js'), 'utf8');
+const table  = script.match(/const MORSE_CODE = \{[\s\S]*?\n\};/)[0];
+const fn     = script.match(/function generateMorseSegments[\s\S]*?\n\}/)[0];
+const generateMorseSegments = new Function(table + '\n' + fn + '\nreturn generateMorseSegments;')();
+
+function editorRuns(input, dit) {
+  let text = input.replace(/ß/g, 'ẞ').toUpperCase();
+  if (text && !text.endsWith(' ')) text += ' ';
+
+  const segments = generateMorseSegments(text, dit);
+  const runs = [];
+  let last = null;
+  for (const s of segments) {
+    if (s.state === last) runs[runs.length - 1] += s.duration;
+    else runs.push(s.duration);
+    last = s.state;
+  }
+  return { first: segments.length ? segments[0].state : 'HIGH', runs: runs.length ? runs.join(',') : '-' };
+}
+
+// name dit first runs "text" – der Text reicht bis zum letzten Anführungszeichen der Zeile
+const CASE = /^(\S+)\s+(\d+)\s+(\S+)\s+(\S+)\s+"(.*)"\s*$/;
+
+let failures = 0;
+const lines = fs.readFileSync(goldenPath, 'utf8').split('\n');
+const out = lines.map(line => {
+  const m = line.startsWith('#') ? null : line.match(CASE);
+  if (!m) return line;
+  const [, name, dit, first, runs, text] = m;
+  const actual = editorRuns(text, parseInt(dit, 10));
+  const ok = actual.first === first && actual.runs === runs;
+  if (!ok && !update) failures++;
+  console.log(`${name.padEnd(20)} ${ok ? 'ok' : update ? 'updated' : 'FAIL'}`);
+  return `${name.padEnd(20)} ${dit.padStart(4)}  ${actual.first.padEnd(5)} ${actual.runs} "${text}"`;
+});
+
+if (update) fs.writeFileSync(goldenPath, out.join('\n'));
+process.exit(failures > 0 ? 1 : 0);